@@ -0,0 +1,623 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Typed views of the backend configuration and properties documents.
+//!
+//! Building a target needs only a few fields of these documents, which run to hundreds of
+//! kilobytes for a Heron device. The structs here borrow their strings from the response body,
+//! and serde skips every field they don't name without building anything for it, so parsing
+//! allocates little beyond the lists of gates and qubits.
+
+use ibm_quantum_platform_api::apis::decode_json;
+use serde::{Deserialize, Serialize};
+use std::borrow::Cow;
+use std::collections::HashMap;
+use std::sync::OnceLock;
+
+use crate::fidelity::FidelityIndex;
+use crate::qiskit_target::{ISAGate, Target};
+
+#[derive(Debug, Deserialize)]
+pub(crate) struct BackendConfiguration {
+    pub n_qubits: u32,
+}
+
+#[derive(Debug, Deserialize)]
+pub(crate) struct BackendProperties<'a> {
+    #[serde(borrow, default)]
+    pub last_update_date: Option<Cow<'a, str>>,
+    #[serde(borrow)]
+    pub gates: Vec<GateProperties<'a>>,
+    #[serde(borrow)]
+    pub qubits: Vec<Vec<Nduv<'a>>>,
+}
+
+#[derive(Debug, Deserialize)]
+pub(crate) struct GateProperties<'a> {
+    #[serde(borrow)]
+    pub gate: Cow<'a, str>,
+    pub qubits: Vec<u32>,
+    #[serde(borrow)]
+    pub parameters: Vec<Nduv<'a>>,
+}
+
+/// A named, dated value with a unit, as the properties document lists them.
+#[derive(Debug, Deserialize)]
+pub(crate) struct Nduv<'a> {
+    #[serde(borrow)]
+    pub name: Cow<'a, str>,
+    #[serde(borrow, default)]
+    pub unit: Cow<'a, str>,
+    pub value: Option<f64>,
+}
+
+impl Nduv<'_> {
+    /// The value in seconds, for a duration.
+    fn seconds(&self) -> Result<Option<f64>, String> {
+        let scale = match self.unit.as_ref() {
+            "s" => 1.,
+            "ms" => 1e-3,
+            "us" | "µs" => 1e-6,
+            "ns" => 1e-9,
+            unit => return Err(format!("Unknown unit for {}: {:?}", self.name, unit)),
+        };
+        Ok(self.value.map(|x| x * scale))
+    }
+}
+
+/// Duration and error, in the order [Target] takes them.
+pub(crate) type InstructionProperties = [Option<f64>; 2];
+
+/// The outcome of bringing a target up to date in place.
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default, PartialEq, Eq)]
+pub struct TargetRefresh {
+    /// Gate entries whose duration or error changed and were updated.
+    pub updated: u32,
+    /// Entries whose properties did not change.
+    pub unchanged: u32,
+    /// Entries that changed but cannot be updated in place: measurements, resets and gates
+    /// on qargs the target doesn't have. The target must be rebuilt to pick these up.
+    pub not_applied: u32,
+}
+
+/// Compare properties bit for bit, so an unchanged NaN or missing value stays unchanged.
+fn same_properties(a: &InstructionProperties, b: &InstructionProperties) -> bool {
+    a.iter()
+        .zip(b)
+        .all(|(a, b)| a.map(f64::to_bits) == b.map(f64::to_bits))
+}
+
+/// Everything a target is built from, extracted from the configuration and properties.
+#[derive(Debug, Default, Deserialize, Serialize)]
+pub(crate) struct TargetData {
+    pub num_qubits: u32,
+    /// When the properties were last updated, which changes with every calibration.
+    pub calibration: Option<String>,
+    /// The properties of each gate, in the order the gates first appear.
+    pub gates: Vec<(ISAGate, Vec<(Vec<u32>, InstructionProperties)>)>,
+    pub reset: Vec<(u32, InstructionProperties)>,
+    pub measure: Vec<(u32, InstructionProperties)>,
+    /// Built on first use, and shared by everyone holding this data.
+    #[serde(skip)]
+    pub(crate) coupling_map: OnceLock<WeightedCouplingMap>,
+    #[serde(skip)]
+    pub(crate) fidelity_index: OnceLock<FidelityIndex>,
+}
+
+/// The coupling map of a backend in compressed sparse row form, weighted with the properties of
+/// its two-qubit gate and the readout error of each qubit.
+///
+/// The edges leaving qubit `q` are `columns[offsets[q]..offsets[q + 1]]`, in increasing order,
+/// and the edge arrays are indexed like `columns`. Edges are directed as the gate is reported, so
+/// a coupler with a symmetric gate such as CZ appears in both rows. An unknown value is NaN.
+#[derive(Debug, Default)]
+pub(crate) struct WeightedCouplingMap {
+    pub offsets: Vec<u32>,
+    pub columns: Vec<u32>,
+    pub edge_error: Vec<f64>,
+    pub edge_duration: Vec<f64>,
+    pub readout_error: Vec<f64>,
+}
+
+impl BackendConfiguration {
+    pub fn parse(body: &mut [u8]) -> Result<Self, String> {
+        decode_json(body).map_err(|e| format!("Invalid backend configuration: {}", e))
+    }
+}
+
+impl TargetData {
+    #[cfg(test)]
+    pub fn parse(configuration: &str, properties: &str) -> Result<Self, String> {
+        let configuration = BackendConfiguration::parse(&mut configuration.as_bytes().to_vec())?;
+        let properties = Self::parse_properties(&mut properties.as_bytes().to_vec())?;
+        Ok(properties.with_configuration(&configuration))
+    }
+
+    /// Extract the gate and readout properties; the qubit count comes from the configuration
+    /// through [TargetData::with_configuration]. The body is decoded in place, see
+    /// [ibm_quantum_platform_api::apis::JsonDecoder].
+    pub fn parse_properties(body: &mut [u8]) -> Result<Self, String> {
+        let properties: BackendProperties =
+            decode_json(body).map_err(|e| format!("Invalid backend properties: {}", e))?;
+        Self::from_properties(&properties)
+    }
+
+    pub fn with_configuration(mut self, configuration: &BackendConfiguration) -> Self {
+        self.num_qubits = configuration.n_qubits;
+        self
+    }
+
+    fn from_properties(properties: &BackendProperties) -> Result<Self, String> {
+        let mut data = TargetData {
+            calibration: properties.last_update_date.as_deref().map(str::to_string),
+            ..Default::default()
+        };
+        for gate in &properties.gates {
+            let mut error = None;
+            let mut duration = None;
+            for param in &gate.parameters {
+                match param.name.as_ref() {
+                    "gate_error" => error = param.value,
+                    "gate_length" => duration = param.seconds()?,
+                    _ => (),
+                }
+            }
+            let props = [duration, error];
+            if gate.gate == "reset" {
+                let Some(&qubit) = gate.qubits.first() else {
+                    return Err("Reset properties without a qubit".to_string());
+                };
+                data.reset.push((qubit, props));
+                continue;
+            }
+            let Some(isa_gate) = ISAGate::from_name(&gate.gate) else {
+                return Err(format!(
+                    "Unsupported gate in backend properties: {}",
+                    gate.gate
+                ));
+            };
+            // The target can't bound the RZZ angle, so out of range angles are folded when
+            // the circuit is encoded for submission.
+            let entry = match data.gates.iter().position(|(x, _)| *x == isa_gate) {
+                Some(pos) => &mut data.gates[pos].1,
+                None => {
+                    data.gates.push((isa_gate, Vec::new()));
+                    &mut data.gates.last_mut().unwrap().1
+                }
+            };
+            entry.push((gate.qubits.clone(), props));
+        }
+        for (qubit, params) in properties.qubits.iter().enumerate() {
+            let mut error = None;
+            let mut duration = None;
+            for param in params {
+                match param.name.as_ref() {
+                    "readout_error" => error = param.value,
+                    "readout_length" => duration = param.seconds()?,
+                    _ => (),
+                }
+            }
+            data.measure.push((qubit as u32, [duration, error]));
+        }
+        Ok(data)
+    }
+
+    pub fn build(&self) -> Target {
+        let mut target = Target::new(self.num_qubits);
+        for (gate, props) in &self.gates {
+            target.add_gate(*gate, props.iter().cloned());
+        }
+        if !self.reset.is_empty() {
+            target.add_reset(self.reset.iter().copied());
+        }
+        target.add_measure(self.measure.iter().copied());
+        target
+    }
+
+    /// The data of the region of `qubits`, with `qubits[i]` renumbered to qubit `i`. Gates on
+    /// any qubit outside the region are dropped.
+    pub fn restrict(&self, qubits: &[u32]) -> TargetData {
+        let index: HashMap<u32, u32> = qubits.iter().copied().zip(0..).collect();
+        let single = |entries: &[(u32, InstructionProperties)]| {
+            entries
+                .iter()
+                .filter_map(|(qubit, props)| Some((*index.get(qubit)?, *props)))
+                .collect()
+        };
+        TargetData {
+            num_qubits: qubits.len() as u32,
+            calibration: self.calibration.clone(),
+            gates: self
+                .gates
+                .iter()
+                .map(|(gate, props)| {
+                    let props = props
+                        .iter()
+                        .filter_map(|(qargs, props)| {
+                            let qargs = qargs
+                                .iter()
+                                .map(|q| index.get(q).copied())
+                                .collect::<Option<Vec<u32>>>()?;
+                            Some((qargs, *props))
+                        })
+                        .collect();
+                    (*gate, props)
+                })
+                .collect(),
+            reset: single(&self.reset),
+            measure: single(&self.measure),
+            ..Default::default()
+        }
+    }
+
+    /// The weighted coupling map, built from the backend's two-qubit gate.
+    ///
+    /// Fractional RZZ gates only count on backends without another two-qubit gate, as circuits
+    /// are routed with the native entangling gate. Where several gates act on the same qubits,
+    /// the one with the lowest error is used.
+    pub fn coupling_map(&self) -> &WeightedCouplingMap {
+        self.coupling_map.get_or_init(|| {
+            let two_qubit = |gate: &&(ISAGate, Vec<(Vec<u32>, InstructionProperties)>)| {
+                gate.1.iter().any(|(qargs, _)| qargs.len() == 2)
+            };
+            let has_native = self
+                .gates
+                .iter()
+                .filter(two_qubit)
+                .any(|(gate, _)| *gate != ISAGate::RZZ);
+            let mut edges: HashMap<(u32, u32), InstructionProperties> = HashMap::new();
+            for (gate, props) in self.gates.iter().filter(two_qubit) {
+                if has_native && *gate == ISAGate::RZZ {
+                    continue;
+                }
+                for (qargs, props) in props {
+                    let &[a, b] = qargs.as_slice() else {
+                        continue;
+                    };
+                    if a == b || a >= self.num_qubits || b >= self.num_qubits {
+                        continue;
+                    }
+                    let error = |x: &InstructionProperties| x[1].unwrap_or(f64::INFINITY);
+                    let edge = edges.entry((a, b)).or_insert(*props);
+                    if error(props) < error(edge) {
+                        *edge = *props;
+                    }
+                }
+            }
+            let mut edges: Vec<_> = edges.into_iter().collect();
+            edges.sort_unstable_by_key(|(qargs, _)| *qargs);
+            let mut map = WeightedCouplingMap {
+                offsets: vec![0; self.num_qubits as usize + 1],
+                readout_error: vec![f64::NAN; self.num_qubits as usize],
+                ..Default::default()
+            };
+            for ((a, b), [duration, error]) in edges {
+                map.offsets[a as usize + 1] += 1;
+                map.columns.push(b);
+                map.edge_error.push(error.unwrap_or(f64::NAN));
+                map.edge_duration.push(duration.unwrap_or(f64::NAN));
+            }
+            for q in 0..self.num_qubits as usize {
+                map.offsets[q + 1] += map.offsets[q];
+            }
+            for (qubit, [_, error]) in &self.measure {
+                if let Some(readout) = map.readout_error.get_mut(*qubit as usize) {
+                    *readout = error.unwrap_or(f64::NAN);
+                }
+            }
+            map
+        })
+    }
+
+    /// The fidelity of every supported instruction, built on first use.
+    pub fn fidelity_index(&self) -> &FidelityIndex {
+        self.fidelity_index.get_or_init(|| FidelityIndex::new(self))
+    }
+
+    /// Bring `target`, up to date with `previous`, up to date with this data by updating only
+    /// the gate properties that changed.
+    ///
+    /// Also returns the data the target is up to date with afterwards: this data, except for
+    /// the entries that weren't applied, which keep their previous properties or are left out
+    /// if they had none. A later refresh against it reports them as not applied again.
+    pub fn update_target(
+        &self,
+        previous: &TargetData,
+        target: &mut Target,
+    ) -> (TargetRefresh, TargetData) {
+        let mut refresh = TargetRefresh::default();
+        let previous_gates: HashMap<(ISAGate, &[u32]), &InstructionProperties> = previous
+            .gates
+            .iter()
+            .flat_map(|(gate, props)| {
+                props
+                    .iter()
+                    .map(move |(qargs, props)| ((*gate, qargs.as_slice()), props))
+            })
+            .collect();
+        let mut applied = TargetData {
+            num_qubits: self.num_qubits,
+            calibration: self.calibration.clone(),
+            // The target can't take measurement and reset properties.
+            measure: previous.measure.clone(),
+            reset: previous.reset.clone(),
+            ..Default::default()
+        };
+        for (gate, props) in &self.gates {
+            let mut entries = Vec::with_capacity(props.len());
+            for (qargs, props) in props {
+                let old = previous_gates.get(&(*gate, qargs.as_slice()));
+                match old {
+                    Some(old) if same_properties(old, props) => refresh.unchanged += 1,
+                    _ if target.update_property(*gate, qargs, *props) => refresh.updated += 1,
+                    _ => {
+                        refresh.not_applied += 1;
+                        if let Some(old) = old {
+                            entries.push((qargs.clone(), **old));
+                        }
+                        continue;
+                    }
+                }
+                entries.push((qargs.clone(), *props));
+            }
+            applied.gates.push((*gate, entries));
+        }
+        for (entries, old) in [
+            (&self.measure, &previous.measure),
+            (&self.reset, &previous.reset),
+        ] {
+            let old: HashMap<u32, &InstructionProperties> =
+                old.iter().map(|(qubit, props)| (*qubit, props)).collect();
+            for (qubit, props) in entries {
+                if old
+                    .get(qubit)
+                    .is_some_and(|old| same_properties(old, props))
+                {
+                    refresh.unchanged += 1;
+                } else {
+                    refresh.not_applied += 1;
+                }
+            }
+        }
+        (refresh, applied)
+    }
+}
+
+#[cfg(test)]
+pub(crate) mod tests {
+    use super::*;
+    use serde_json::{json, Value};
+    use std::collections::HashMap;
+    use std::time::Instant;
+
+    fn nduv(name: &str, unit: &str, value: f64) -> Value {
+        json!({"date": "2025-06-01T08:00:00Z", "name": name, "unit": unit, "value": value})
+    }
+
+    /// Configuration and properties documents shaped like those of a 156 qubit Heron device.
+    pub(crate) fn heron_documents() -> (String, String) {
+        let num_qubits = 156u32;
+        let edges: Vec<[u32; 2]> = (0..num_qubits - 1)
+            .map(|q| [q, q + 1])
+            .chain((0..num_qubits - 16).step_by(4).map(|q| [q, q + 16]))
+            .collect();
+        let coupling_map: Vec<[u32; 2]> =
+            edges.iter().flat_map(|&[a, b]| [[a, b], [b, a]]).collect();
+        let gate_definitions: Vec<Value> = ["id", "rz", "sx", "x", "cz"]
+            .iter()
+            .map(|name| {
+                json!({
+                    "name": name,
+                    "parameters": [],
+                    "qasm_def": format!("gate {name} q {{ U(0, 0, 0) q; }}"),
+                    "coupling_map": (0..num_qubits).map(|q| [q]).collect::<Vec<_>>(),
+                })
+            })
+            .collect();
+        let configuration = json!({
+            "backend_name": "ibm_heron",
+            "backend_version": "1.2.3",
+            "n_qubits": num_qubits,
+            "basis_gates": ["cz", "id", "rx", "rz", "rzz", "sx", "x"],
+            "coupling_map": coupling_map,
+            "dt": 5e-10,
+            "processor_type": {"family": "Heron", "revision": 2},
+            "supported_instructions": ["cz", "id", "delay", "measure", "reset", "rx", "rz", "rzz", "sx", "x"],
+            "gates": gate_definitions,
+        });
+        let mut gates = Vec::new();
+        for q in 0..num_qubits {
+            for (gate, length) in [
+                ("id", 32.),
+                ("rz", 0.),
+                ("sx", 32.),
+                ("x", 32.),
+                ("rx", 32.),
+                ("reset", 1.3e3),
+            ] {
+                gates.push(json!({
+                    "qubits": [q],
+                    "gate": gate,
+                    "name": format!("{gate}{q}"),
+                    "parameters": [nduv("gate_error", "", 2.5e-4), nduv("gate_length", "ns", length)],
+                }));
+            }
+        }
+        for gate in ["cz", "rzz"] {
+            for &[a, b] in &edges {
+                for (a, b) in [(a, b), (b, a)] {
+                    gates.push(json!({
+                        "qubits": [a, b],
+                        "gate": gate,
+                        "name": format!("{gate}{a}_{b}"),
+                        "parameters": [nduv("gate_error", "", 3e-3), nduv("gate_length", "ns", 68.)],
+                    }));
+                }
+            }
+        }
+        let qubits: Vec<Value> = (0..num_qubits)
+            .map(|_| {
+                json!([
+                    nduv("T1", "us", 250.),
+                    nduv("T2", "us", 150.),
+                    nduv("frequency", "GHz", 4.8),
+                    nduv("anharmonicity", "GHz", -0.3),
+                    nduv("readout_error", "", 1.2e-2),
+                    nduv("prob_meas0_prep1", "", 1.5e-2),
+                    nduv("prob_meas1_prep0", "", 0.9e-2),
+                    nduv("readout_length", "ns", 1560.),
+                ])
+            })
+            .collect();
+        let properties = json!({
+            "backend_name": "ibm_heron",
+            "backend_version": "1.2.3",
+            "last_update_date": "2025-06-01T08:00:00Z",
+            "general": [],
+            "gates": gates,
+            "qubits": qubits,
+        });
+        (configuration.to_string(), properties.to_string())
+    }
+
+    #[test]
+    fn heron_documents_parse_into_target_data() {
+        let (configuration, properties) = heron_documents();
+        let data = TargetData::parse(&configuration, &properties).unwrap();
+        assert_eq!(data.num_qubits, 156);
+        assert_eq!(data.calibration.as_deref(), Some("2025-06-01T08:00:00Z"));
+        let names: Vec<ISAGate> = data.gates.iter().map(|(gate, _)| *gate).collect();
+        assert_eq!(
+            names,
+            [
+                ISAGate::I,
+                ISAGate::RZ,
+                ISAGate::SX,
+                ISAGate::X,
+                ISAGate::RX,
+                ISAGate::CZ,
+                ISAGate::RZZ
+            ]
+        );
+        let (_, cz) = &data.gates[5];
+        assert_eq!(cz[0], (vec![0, 1], [Some(68e-9), Some(3e-3)]));
+        assert_eq!(data.reset.len(), 156);
+        assert_eq!(data.measure.len(), 156);
+        assert_eq!(data.measure[7], (7, [Some(1.56e-6), Some(1.2e-2)]));
+
+        let bad = properties.replace("\"ns\"", "\"fortnights\"");
+        assert!(TargetData::parse(&configuration, &bad).is_err());
+    }
+
+    #[test]
+    fn coupling_map_is_compressed_sparse_rows() {
+        let (configuration, properties) = heron_documents();
+        let data = TargetData::parse(&configuration, &properties).unwrap();
+        let map = data.coupling_map();
+        assert_eq!(map.offsets.len(), 157);
+        assert_eq!(*map.offsets.last().unwrap() as usize, map.columns.len());
+        assert_eq!(map.edge_error.len(), map.columns.len());
+        assert_eq!(map.edge_duration.len(), map.columns.len());
+        assert_eq!(map.readout_error.len(), 156);
+        // CZ is reported in both directions, and RZZ doesn't add edges of its own.
+        let cz = &data
+            .gates
+            .iter()
+            .find(|(gate, _)| *gate == ISAGate::CZ)
+            .unwrap()
+            .1;
+        assert_eq!(map.columns.len(), cz.len());
+        for (qargs, [duration, error]) in cz {
+            let (a, b) = (qargs[0] as usize, qargs[1]);
+            let row = map.offsets[a] as usize..map.offsets[a + 1] as usize;
+            let i = row.start + map.columns[row].binary_search(&b).unwrap();
+            assert_eq!(Some(map.edge_error[i]), *error);
+            assert_eq!(Some(map.edge_duration[i]), *duration);
+        }
+        for (qubit, [_, error]) in &data.measure {
+            assert_eq!(Some(map.readout_error[*qubit as usize]), *error);
+        }
+        // The map is built once and shared.
+        assert!(std::ptr::eq(map, data.coupling_map()));
+    }
+
+    #[test]
+    fn update_target_applies_only_changes() {
+        let (configuration, properties) = heron_documents();
+        let previous = TargetData::parse(&configuration, &properties).unwrap();
+        let mut latest = TargetData::parse(&configuration, &properties).unwrap();
+        latest.gates[5].1[0].1 = [Some(68e-9), Some(5e-3)];
+        latest.measure[3].1 = [Some(1.56e-6), Some(2e-2)];
+        let gate_entries: u32 = latest.gates.iter().map(|(_, x)| x.len() as u32).sum();
+        let single_qubit_entries = (latest.measure.len() + latest.reset.len()) as u32;
+
+        let mut target = previous.build();
+        let (refresh, applied) = latest.update_target(&previous, &mut target);
+        assert_eq!(
+            refresh,
+            TargetRefresh {
+                updated: 1,
+                unchanged: gate_entries + single_qubit_entries - 2,
+                not_applied: 1,
+            }
+        );
+        assert_eq!(applied.gates[5].1[0].1, latest.gates[5].1[0].1);
+        assert_eq!(applied.measure[3].1, previous.measure[3].1);
+
+        // The measurement the target never received is still reported on the next refresh.
+        let (refresh, _) = latest.update_target(&applied, &mut target);
+        assert_eq!(
+            refresh,
+            TargetRefresh {
+                updated: 0,
+                unchanged: gate_entries + single_qubit_entries - 1,
+                not_applied: 1,
+            }
+        );
+    }
+
+    /// Compare parsing the Heron documents into `Value` trees, as the target was built before,
+    /// with parsing them into the typed views.
+    ///
+    /// Run with ``cargo test --release -- --ignored --nocapture bench_``.
+    #[test]
+    #[ignore]
+    #[allow(clippy::print_stderr)]
+    fn bench_heron_documents() {
+        let (configuration, properties) = heron_documents();
+        let iterations = 200;
+
+        let start = Instant::now();
+        for _ in 0..iterations {
+            let configuration: HashMap<String, Value> =
+                serde_json::from_str(&configuration).unwrap();
+            let properties: HashMap<String, Value> = serde_json::from_str(&properties).unwrap();
+            std::hint::black_box((configuration, properties));
+        }
+        let value_time = start.elapsed() / iterations;
+
+        let start = Instant::now();
+        for _ in 0..iterations {
+            std::hint::black_box(TargetData::parse(&configuration, &properties).unwrap());
+        }
+        let typed_time = start.elapsed() / iterations;
+
+        eprintln!(
+            "Heron documents ({} + {} bytes): Value {:?}, typed {:?} per parse",
+            configuration.len(),
+            properties.len(),
+            value_time,
+            typed_time
+        );
+    }
+}
@@ -12,20 +12,34 @@
 
 use crate::generate_job_params::create_sampler_job_payload;
 use crate::generate_qpy::generate_qpy_payload;
-use crate::pointers::const_ptr_as_ref;
+use crate::isa::{IsaReport, IsaViolation};
+use crate::pipeline::{Pipeline, PipelineOptions, PipelineStageStats, NUM_STAGES};
+use crate::pointers::{const_ptr_as_ref, mut_ptr_as_ref};
 use crate::qiskit_circuit::Circuit;
-use crate::qiskit_ffi::{QkCircuit, QkTarget};
+use crate::qiskit_ffi::{
+    qk_transpiler_default_options, QkCircuit, QkTarget, QkTranspileOptions, QkTranspileResult,
+};
 use crate::{log_err, ExitCode};
-use std::ffi::{c_char, CStr, CString};
+use std::ffi::{c_char, c_void, CStr, CString};
 use std::fs::File;
 use std::io::prelude::*;
 use std::path::Path;
+use std::time::Duration;
 
+use crate::backend_data::TargetRefresh;
+use crate::predictor::{CompletionPrediction, QpuTimeEstimate};
+use crate::qubit_subset::SubsetObjective;
 use crate::service::{
-    get_account_from_config, get_backend, get_backends, get_job_details, get_job_results,
-    get_job_status, list_instances, submit_sampler_job, Backend, BackendSearchResults, Job,
-    JobDetails, Samples, Service, ServiceError,
+    bootstrap_service, check_isa, dry_run_sampler_job, estimate_backend_qpu_time,
+    estimate_success_probabilities, estimate_success_probability, get_account_from_config,
+    get_backend, get_backend_target, get_backends, get_best_subset, get_coupling_graph,
+    get_job_details, get_job_results, get_job_status, predict_completion, predict_job_completion,
+    refresh_backend_status, refresh_target, search_backends, start_pipeline, submit_sampler_job,
+    transpile_best_of, transpile_cached, Backend, BackendQuery, BackendSearchResults,
+    BackendStatus, BackendTarget, BackendWatcher, CouplingGraph, InstanceLoad, Job, JobDetails,
+    SamplerDryRun, Samples, Service, ServiceError, StartupTimings, DEFAULT_PREFETCH_CONCURRENCY,
 };
+use crate::transpile::{TranspileSelection, TranspileTrial};
 
 macro_rules! check_result {
     ($expr:expr) => {
@@ -85,8 +99,54 @@ pub unsafe extern "C" fn qkrt_sampler_job_write_payload(
     serde_json::to_writer_pretty(file, &model).unwrap();
 }
 
+/// Options controlling how ``qkrt_service_new_with_options`` brings up a service.
+#[repr(C)]
+pub struct ServiceOptions {
+    /// Path of the account configuration file, or NULL for ``~/.qiskit/qiskit-ibm.json``.
+    pub filename: *const c_char,
+    /// Name of the account to use, or NULL for the default account.
+    pub account_name: *const c_char,
+    /// List the backends on a background thread while the caller carries on.
+    pub prefetch_backends: bool,
+    /// Also build the targets of all listed backends in the background.
+    pub prefetch_targets: bool,
+    /// Seconds for which instance discovery and backend listings are served from the on-disk
+    /// discovery cache, or 0 to disable the cache.
+    pub discovery_cache_ttl: u64,
+    /// List a backend reachable from several instances once, through the least loaded one.
+    pub balance_instances: bool,
+    /// The most built targets kept in memory, or 0 for the default.
+    pub max_cached_targets: u32,
+    /// Check circuits against the backend before submitting them.
+    pub validate_isa: bool,
+}
+
+unsafe fn optional_str<'a>(ptr: *const c_char) -> Option<&'a str> {
+    if ptr.is_null() {
+        None
+    } else {
+        unsafe { Some(CStr::from_ptr(ptr).to_str().unwrap()) }
+    }
+}
+
+/// Convert an enum passed from C as its value, which C doesn't limit to the declared variants.
+fn enum_arg<T: TryFrom<u32>>(value: u32, name: &str) -> Result<T, ServiceError> {
+    T::try_from(value).map_err(|_| ServiceError {
+        code: ExitCode::BadArgumentError,
+        message: format!("Invalid {}: {}", name, value),
+    })
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn qkrt_service_new(out: *mut *mut Service) -> ExitCode {
+    qkrt_service_new_with_options(out, std::ptr::null())
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_service_new_with_options(
+    out: *mut *mut Service,
+    options: *const ServiceOptions,
+) -> ExitCode {
     if out.is_null() {
         return ExitCode::NullPointerError;
     }
@@ -95,16 +155,57 @@ pub unsafe extern "C" fn qkrt_service_new(out: *mut *mut Service) -> ExitCode {
         .enable_all()
         .build()
         .unwrap();
-    let account = check_result!(rt.block_on(get_account_from_config(None, None)));
-    let mut instances = check_result!(rt.block_on(list_instances(&account)));
-    if let Some(instance) = &account.config.instance {
-        // Filter-out any instance that doesn't match the user's config.
-        instances = instances
-            .into_iter()
-            .filter(|x| &x.crn.to_str().unwrap() == &instance)
-            .collect()
-    }
-    *out = Box::into_raw(Box::new(Service::new(account, instances)));
+    let service = if options.is_null() {
+        rt.block_on(bootstrap_service(None, None, false, false, None))
+    } else {
+        let options = const_ptr_as_ref(options);
+        rt.block_on(bootstrap_service(
+            optional_str(options.filename),
+            optional_str(options.account_name),
+            options.prefetch_backends,
+            options.prefetch_targets,
+            (options.discovery_cache_ttl > 0)
+                .then(|| Duration::from_secs(options.discovery_cache_ttl)),
+        ))
+    };
+    let mut service = check_result!(service);
+    if !options.is_null() {
+        let options = const_ptr_as_ref(options);
+        if options.balance_instances {
+            service.enable_instance_balancing();
+        }
+        if options.max_cached_targets > 0 {
+            service.limit_target_cache(options.max_cached_targets as usize);
+        }
+        if options.validate_isa {
+            service.enable_isa_validation();
+        }
+    }
+    *out = Box::into_raw(Box::new(service));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_service_refresh(service: *mut Service) -> ExitCode {
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = mut_ptr_as_ref(service);
+    check_result!(rt.block_on(service.refresh()));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_service_startup_timings(
+    out: *mut StartupTimings,
+    service: *const Service,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let service = const_ptr_as_ref(service);
+    *out = service.timings();
     ExitCode::Success
 }
 
@@ -135,6 +236,63 @@ pub unsafe extern "C" fn qkrt_backend_search(
     ExitCode::Success
 }
 
+/// Filter criteria and ranking weights for ``qkrt_backend_search_filtered``.
+///
+/// A zero-initialized filter matches every backend and keeps listing order.
+#[repr(C)]
+pub struct BackendFilter {
+    /// Minimum number of qubits, or 0 for any.
+    pub min_qubits: u32,
+    /// Only match backends that are online.
+    pub operational_only: bool,
+    /// A [crate::service::SimulatorFilter] value.
+    pub simulator: u32,
+    /// Processor family to match (case-insensitive), or NULL for any.
+    pub processor_family: *const c_char,
+    /// Weight of the queue length in the ranking score.
+    pub queue_length_weight: f64,
+    /// Weight of CLOPS in the ranking score.
+    pub clops_weight: f64,
+    /// Weight of the layered two-qubit error in the ranking score.
+    pub two_q_error_weight: f64,
+    /// Maximum number of results, or 0 for all matches.
+    pub top_k: usize,
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_search_filtered(
+    out: *mut *mut BackendSearchResults,
+    service: *const Service,
+    filter: *const BackendFilter,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
+    let query = if filter.is_null() {
+        BackendQuery::default()
+    } else {
+        let filter = const_ptr_as_ref(filter);
+        BackendQuery {
+            min_qubits: filter.min_qubits,
+            operational_only: filter.operational_only,
+            simulator: check_result!(enum_arg(filter.simulator, "SimulatorFilter")),
+            processor_family: optional_str(filter.processor_family).map(|x| x.to_string()),
+            queue_length_weight: filter.queue_length_weight,
+            clops_weight: filter.clops_weight,
+            two_q_error_weight: filter.two_q_error_weight,
+            top_k: filter.top_k,
+        }
+    };
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let results = check_result!(rt.block_on(search_backends(const_ptr_as_ref(service), &query)));
+    *out = Box::into_raw(Box::new(results));
+    ExitCode::Success
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn qkrt_backend_search_results_free(results: *mut BackendSearchResults) {
     if !results.is_null() {
@@ -144,6 +302,22 @@ pub unsafe extern "C" fn qkrt_backend_search_results_free(results: *mut BackendS
     }
 }
 
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_search_results_prefetch_targets(
+    results: *const BackendSearchResults,
+    service: *const Service,
+    top_n: u32,
+    max_concurrent: u32,
+) {
+    let results = const_ptr_as_ref(results);
+    let service = const_ptr_as_ref(service);
+    let max_concurrent = match max_concurrent {
+        0 => DEFAULT_PREFETCH_CONCURRENCY,
+        n => n as usize,
+    };
+    results.prefetch_targets(service, top_n as usize, max_concurrent);
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn qkrt_backend_search_results_length(
     results: *const BackendSearchResults,
@@ -168,21 +342,478 @@ pub unsafe extern "C" fn qkrt_backend_search_results_least_busy(
     results.least_busy()
 }
 
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_search_results_least_time(
+    results: *const BackendSearchResults,
+    service: *const Service,
+    circuit: *mut QkCircuit,
+    shots: i32,
+) -> *const Backend {
+    let results = const_ptr_as_ref(results);
+    let service = const_ptr_as_ref(service);
+    let shots = if shots < 0 { None } else { Some(shots) };
+    results.least_time(service, &Circuit(circuit), shots)
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_predict_completion(
+    out: *mut CompletionPrediction,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+    shots: i32,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let shots = if shots < 0 { None } else { Some(shots) };
+    *out = predict_completion(service, backend, &Circuit(circuit), shots);
+    ExitCode::Success
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn qkrt_get_backend_target(
+    out: *mut *mut QkTarget,
     service: *const Service,
     backend: *const Backend,
-) -> *const QkTarget {
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
     let rt = tokio::runtime::Builder::new_current_thread()
         .enable_all()
         .build()
         .unwrap();
     let service = const_ptr_as_ref(service);
     let backend = const_ptr_as_ref(backend);
-    let result = rt.block_on(get_backend(service, backend));
-    let output = result.0;
+    let result = check_result!(rt.block_on(get_backend(service, backend)));
+    *out = result.0;
     std::mem::forget(result);
-    output
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_target_new(
+    out: *mut *mut BackendTarget,
+    service: *const Service,
+    backend: *const Backend,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let target = check_result!(rt.block_on(get_backend_target(service, backend)));
+    *out = Box::into_raw(Box::new(target));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_target_get(target: *const BackendTarget) -> *mut QkTarget {
+    const_ptr_as_ref(target).target().0
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_target_refresh(
+    out: *mut TargetRefresh,
+    service: *const Service,
+    target: *mut BackendTarget,
+) -> ExitCode {
+    if out.is_null() || target.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let target = mut_ptr_as_ref(target);
+    *out = check_result!(rt.block_on(refresh_target(service, target)));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_target_free(target: *mut BackendTarget) {
+    if !target.is_null() {
+        unsafe {
+            drop(Box::from_raw(target));
+        }
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_best_subset(
+    out: *mut *mut QkTarget,
+    qubits: *mut u32,
+    service: *const Service,
+    backend: *const Backend,
+    k: u32,
+    objective: u32,
+) -> ExitCode {
+    if out.is_null() || qubits.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
+    let objective: SubsetObjective = check_result!(enum_arg(objective, "SubsetObjective"));
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let (target, map) = check_result!(rt.block_on(get_best_subset(service, backend, k, objective)));
+    std::ptr::copy_nonoverlapping(map.as_ptr(), qubits, map.len());
+    *out = target.0;
+    std::mem::forget(target);
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_coupling_graph(
+    out: *mut *mut CouplingGraph,
+    service: *const Service,
+    backend: *const Backend,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let graph = check_result!(rt.block_on(get_coupling_graph(service, backend)));
+    *out = Box::into_raw(Box::new(graph));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_num_qubits(graph: *const CouplingGraph) -> u32 {
+    const_ptr_as_ref(graph).num_qubits()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_num_edges(graph: *const CouplingGraph) -> usize {
+    const_ptr_as_ref(graph).map().columns.len()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_row_offsets(
+    graph: *const CouplingGraph,
+) -> *const u32 {
+    const_ptr_as_ref(graph).map().offsets.as_ptr()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_columns(graph: *const CouplingGraph) -> *const u32 {
+    const_ptr_as_ref(graph).map().columns.as_ptr()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_edge_errors(
+    graph: *const CouplingGraph,
+) -> *const f64 {
+    const_ptr_as_ref(graph).map().edge_error.as_ptr()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_edge_durations(
+    graph: *const CouplingGraph,
+) -> *const f64 {
+    const_ptr_as_ref(graph).map().edge_duration.as_ptr()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_readout_errors(
+    graph: *const CouplingGraph,
+) -> *const f64 {
+    const_ptr_as_ref(graph).map().readout_error.as_ptr()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_coupling_graph_free(graph: *mut CouplingGraph) {
+    if !graph.is_null() {
+        drop(Box::from_raw(graph));
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_pipeline_new(
+    out: *mut *mut Pipeline,
+    service: *const Service,
+    backend: *const Backend,
+    options: *const PipelineOptions,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let options = if options.is_null() {
+        PipelineOptions {
+            transpile_workers: 0,
+            encode_workers: 0,
+            submit_workers: 0,
+            queue_capacity: 0,
+            shots: 0,
+            transpile: qk_transpiler_default_options(),
+        }
+    } else {
+        *options
+    };
+    let pipeline = check_result!(rt.block_on(start_pipeline(service, backend, &options)));
+    *out = Box::into_raw(Box::new(pipeline));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_pipeline_submit(
+    pipeline: *mut Pipeline,
+    circuit: *mut QkCircuit,
+) -> ExitCode {
+    if circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let pipeline = mut_ptr_as_ref(pipeline);
+    check_result!(pipeline.submit(Circuit(circuit)));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_pipeline_num_circuits(pipeline: *const Pipeline) -> usize {
+    const_ptr_as_ref(pipeline).num_queued()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_pipeline_finish(
+    jobs: *mut *mut Job,
+    pipeline: *mut Pipeline,
+) -> ExitCode {
+    let pipeline = mut_ptr_as_ref(pipeline);
+    let mut code = ExitCode::Success;
+    for (i, outcome) in pipeline.finish().into_iter().enumerate() {
+        let job = match outcome {
+            Ok(job) => Box::into_raw(Box::new(job)),
+            Err(e) => {
+                log_err(&format!("Circuit {} of the pipeline failed: {:?}", i, e));
+                if matches!(code, ExitCode::Success) {
+                    code = e.code();
+                }
+                std::ptr::null_mut()
+            }
+        };
+        if !jobs.is_null() {
+            *jobs.add(i) = job;
+        } else if !job.is_null() {
+            drop(Box::from_raw(job));
+        }
+    }
+    code
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_pipeline_stats(
+    out: *mut PipelineStageStats,
+    pipeline: *const Pipeline,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let stats = const_ptr_as_ref(pipeline).stats();
+    std::ptr::copy_nonoverlapping(stats.as_ptr(), out, NUM_STAGES);
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_pipeline_free(pipeline: *mut Pipeline) {
+    if !pipeline.is_null() {
+        drop(Box::from_raw(pipeline));
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_transpile_best_of(
+    out: *mut QkTranspileResult,
+    trials: *mut TranspileTrial,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+    num_trials: u32,
+    options: *const QkTranspileOptions,
+    selection: u32,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let selection: TranspileSelection = check_result!(enum_arg(selection, "TranspileSelection"));
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let options = if options.is_null() {
+        qk_transpiler_default_options()
+    } else {
+        *options
+    };
+    let (result, stats) = check_result!(rt.block_on(transpile_best_of(
+        service,
+        backend,
+        &Circuit(circuit),
+        num_trials,
+        &options,
+        selection
+    )));
+    if !trials.is_null() {
+        std::ptr::copy_nonoverlapping(stats.as_ptr(), trials, stats.len());
+    }
+    *out = check_result!(result);
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_transpile_cached(
+    out: *mut *mut QkCircuit,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+    options: *const QkTranspileOptions,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let options = if options.is_null() {
+        qk_transpiler_default_options()
+    } else {
+        *options
+    };
+    let transpiled = check_result!(rt.block_on(transpile_cached(
+        service,
+        backend,
+        &Circuit(circuit),
+        &options
+    )));
+    *out = transpiled.0;
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_validate_isa(
+    out: *mut *mut IsaReport,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    *out = std::ptr::null_mut();
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let report = check_result!(rt.block_on(check_isa(service, backend, &Circuit(circuit))));
+    *out = Box::into_raw(Box::new(report));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_isa_report_num_violations(report: *const IsaReport) -> usize {
+    const_ptr_as_ref(report).violations.len()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_isa_report_violations(
+    report: *const IsaReport,
+) -> *const IsaViolation {
+    const_ptr_as_ref(report).violations.as_ptr()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_isa_report_free(report: *mut IsaReport) {
+    if !report.is_null() {
+        drop(Box::from_raw(report));
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_estimate_success_probability(
+    out: *mut f64,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    *out = check_result!(rt.block_on(estimate_success_probability(
+        service,
+        backend,
+        &Circuit(circuit)
+    )));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_estimate_success_probabilities(
+    out: *mut f64,
+    service: *const Service,
+    backends: *const *const Backend,
+    num_backends: usize,
+    circuit: *mut QkCircuit,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() || (backends.is_null() && num_backends > 0) {
+        return ExitCode::NullPointerError;
+    }
+    if num_backends == 0 {
+        return ExitCode::Success;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backends: Vec<&Backend> = std::slice::from_raw_parts(backends, num_backends)
+        .iter()
+        .map(|backend| const_ptr_as_ref(*backend))
+        .collect();
+    let probabilities = check_result!(rt.block_on(estimate_success_probabilities(
+        service,
+        &backends,
+        &Circuit(circuit)
+    )));
+    std::ptr::copy_nonoverlapping(probabilities.as_ptr(), out, num_backends);
+    ExitCode::Success
 }
 
 #[no_mangle]
@@ -203,6 +834,107 @@ pub unsafe extern "C" fn qkrt_backend_instance_name(backend: *const Backend) ->
     backend.instance_name()
 }
 
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_queue_length(backend: *const Backend) -> i32 {
+    let backend = const_ptr_as_ref(backend);
+    backend.queue_length()
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_status(backend: *const Backend) -> u32 {
+    let backend = const_ptr_as_ref(backend);
+    backend.status() as u32
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_instance_load(
+    out: *mut InstanceLoad,
+    backend: *const Backend,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let backend = const_ptr_as_ref(backend);
+    *out = backend.instance_load();
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_refresh_status(
+    service: *const Service,
+    backend: *const Backend,
+) -> ExitCode {
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    check_result!(rt.block_on(refresh_backend_status(service, backend)));
+    ExitCode::Success
+}
+
+/// Called from a backend watcher's thread when a watched backend changes.
+pub type BackendStatusCallback = unsafe extern "C" fn(
+    index: usize,
+    status: BackendStatus,
+    queue_length: i32,
+    user_data: *mut c_void,
+);
+
+struct CallbackContext {
+    callback: BackendStatusCallback,
+    user_data: *mut c_void,
+}
+
+// The caller promises the callback and its user data may be used from the watcher thread.
+unsafe impl Send for CallbackContext {}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_watcher_new(
+    out: *mut *mut BackendWatcher,
+    service: *const Service,
+    results: *const BackendSearchResults,
+    interval_ms: u64,
+    queue_threshold: i32,
+    callback: Option<BackendStatusCallback>,
+    user_data: *mut c_void,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let service = const_ptr_as_ref(service);
+    let results = const_ptr_as_ref(results);
+    let context = callback.map(|callback| CallbackContext {
+        callback,
+        user_data,
+    });
+    let watcher = check_result!(BackendWatcher::new(
+        service,
+        results.backends().cloned().collect(),
+        Duration::from_millis(interval_ms),
+        queue_threshold,
+        Box::new(move |index, _, status, queue_length| {
+            if let Some(context) = &context {
+                unsafe {
+                    (context.callback)(index, status, queue_length, context.user_data);
+                }
+            }
+        }),
+    ));
+    *out = Box::into_raw(Box::new(watcher));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_backend_watcher_free(watcher: *mut BackendWatcher) {
+    if !watcher.is_null() {
+        unsafe {
+            drop(Box::from_raw(watcher));
+        }
+    }
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn qkrt_sampler_job_run(
     out: *mut *mut Job,
@@ -241,6 +973,74 @@ pub unsafe extern "C" fn qkrt_sampler_job_run(
     ExitCode::Success
 }
 
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_sampler_job_dry_run(
+    out: *mut SamplerDryRun,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+    shots: i32,
+    runtime: *const c_char,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let runtime = if runtime.is_null() {
+        None
+    } else {
+        unsafe { Some(CStr::from_ptr(runtime).to_str().unwrap().to_string()) }
+    };
+    let shots = if shots < 0 { None } else { Some(shots) };
+    *out = check_result!(rt.block_on(dry_run_sampler_job(
+        service,
+        backend,
+        &Circuit(circuit),
+        shots,
+        runtime,
+    )));
+    ExitCode::Success
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_estimate_qpu_time(
+    out: *mut QpuTimeEstimate,
+    service: *const Service,
+    backend: *const Backend,
+    circuit: *mut QkCircuit,
+    shots: i32,
+    rep_delay: f64,
+) -> ExitCode {
+    if out.is_null() || circuit.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let backend = const_ptr_as_ref(backend);
+    let shots = if shots < 0 { None } else { Some(shots) };
+    let rep_delay = if rep_delay > 0. {
+        Some(rep_delay)
+    } else {
+        None
+    };
+    *out = check_result!(rt.block_on(estimate_backend_qpu_time(
+        service,
+        backend,
+        &Circuit(circuit),
+        shots,
+        rep_delay,
+    )));
+    ExitCode::Success
+}
+
 #[no_mangle]
 pub unsafe extern "C" fn qkrt_job_free(job: *mut Job) {
     if !job.is_null() {
@@ -343,6 +1143,25 @@ pub unsafe extern "C" fn qkrt_job_status(
     ExitCode::Success
 }
 
+#[no_mangle]
+pub unsafe extern "C" fn qkrt_job_predict_completion(
+    out: *mut CompletionPrediction,
+    service: *const Service,
+    job: *const Job,
+) -> ExitCode {
+    if out.is_null() {
+        return ExitCode::NullPointerError;
+    }
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let service = const_ptr_as_ref(service);
+    let job = const_ptr_as_ref(job);
+    *out = check_result!(rt.block_on(predict_job_completion(service, job)));
+    ExitCode::Success
+}
+
 #[no_mangle]
 pub extern "C" fn get_access_token() {
     let rt = tokio::runtime::Builder::new_current_thread()
@@ -0,0 +1,831 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+use std::collections::HashMap;
+use std::ffi::CString;
+use std::fs::File;
+use std::io::{BufReader, BufWriter};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+
+use ibm_quantum_platform_api::models::BackendsResponseV2DevicesInner;
+
+use crate::backend_data::TargetData;
+use crate::generate_qpy::{decode_qpy, encode_qpy_verbatim};
+use crate::qiskit_circuit::{Circuit, CircuitInstruction};
+use crate::qiskit_ffi::{self, QkTranspileOptions};
+use crate::qiskit_target::Target;
+use crate::service::{AccountEntry, BackendListing, Instance};
+use crate::{log_debug, log_warn};
+
+/// Bump this whenever the layout of [DiscoveryCacheFile] changes so stale files are ignored.
+const DISCOVERY_CACHE_VERSION: u32 = 1;
+/// Bump this whenever the layout of [TargetCacheFile] or [TargetData] changes so stale files
+/// are ignored.
+const TARGET_CACHE_VERSION: u32 = 1;
+/// Bump this whenever the QPY written for transpiled circuits, or what goes into their key,
+/// changes so stale files are ignored.
+const TRANSPILE_CACHE_VERSION: u32 = 2;
+/// How large the directory of transpiled circuits may grow before the least recently used ones
+/// are removed.
+const TRANSPILE_CACHE_MAX_BYTES: u64 = 256 * 1024 * 1024;
+/// How long a cached target is handed out before the backend's calibration is checked again.
+pub(crate) const TARGET_REVALIDATE_INTERVAL: Duration = Duration::from_secs(60);
+/// How many built targets a service keeps in memory unless told otherwise.
+pub(crate) const DEFAULT_TARGET_CACHE_CAPACITY: usize = 32;
+
+/// The directory persistent caches are written to.
+///
+/// This is ``$QISKIT_IBM_RUNTIME_CACHE_DIR`` if set, otherwise
+/// ``$HOME/.qiskit/cache/qiskit-ibm-runtime-c``.
+pub(crate) fn cache_dir() -> Option<PathBuf> {
+    if let Ok(dir) = std::env::var("QISKIT_IBM_RUNTIME_CACHE_DIR") {
+        return Some(PathBuf::from(dir));
+    }
+    let home = std::env::var("HOME").ok()?;
+    Some(
+        Path::new(&home)
+            .join(".qiskit")
+            .join("cache")
+            .join("qiskit-ibm-runtime-c"),
+    )
+}
+
+/// Write `path` with `write` via a temporary file, so concurrent readers never see a partially
+/// written file.
+fn write_atomic(
+    path: &Path,
+    write: impl FnOnce(&mut BufWriter<File>) -> std::io::Result<()>,
+) -> std::io::Result<()> {
+    if let Some(parent) = path.parent() {
+        std::fs::create_dir_all(parent)?;
+    }
+    let tmp = path.with_extension(format!("tmp.{}", std::process::id()));
+    {
+        let mut writer = BufWriter::new(File::create(&tmp)?);
+        write(&mut writer)?;
+        std::io::Write::flush(&mut writer)?;
+    }
+    std::fs::rename(&tmp, path)
+}
+
+/// Write `value` as JSON to `path` via a temporary file.
+pub(crate) fn write_json_atomic<T: Serialize>(path: &Path, value: &T) -> std::io::Result<()> {
+    write_atomic(path, |writer| Ok(serde_json::to_writer(writer, value)?))
+}
+
+/// Read JSON from `path`, returning `None` if it is missing or cannot be parsed.
+pub(crate) fn read_json<T: for<'de> Deserialize<'de>>(path: &Path) -> Option<T> {
+    let file = File::open(path).ok()?;
+    match serde_json::from_reader(BufReader::new(file)) {
+        Ok(value) => Some(value),
+        Err(e) => {
+            log_warn(&format!(
+                "Ignoring unreadable cache {}: {}",
+                path.display(),
+                e
+            ));
+            None
+        }
+    }
+}
+
+fn unix_seconds(time: SystemTime) -> u64 {
+    time.duration_since(UNIX_EPOCH)
+        .map(|d| d.as_secs())
+        .unwrap_or(0)
+}
+
+#[derive(Deserialize, Serialize)]
+struct CachedInstance {
+    crn: String,
+    name: String,
+}
+
+#[derive(Deserialize, Serialize)]
+struct CachedBackend {
+    instance_crn: String,
+    device: BackendsResponseV2DevicesInner,
+}
+
+#[derive(Deserialize, Serialize)]
+struct DiscoveryCacheFile {
+    version: u32,
+    created: u64,
+    instances: Vec<CachedInstance>,
+    backends: Vec<CachedBackend>,
+}
+
+/// The instances and backend listing of one account, as loaded from the discovery cache.
+pub(crate) struct CachedDiscovery {
+    pub created: SystemTime,
+    pub instances: Vec<Instance>,
+    pub listing: BackendListing,
+}
+
+/// Feed a length to a key hash, so that variable-length fields can't run into each other.
+fn update_len(hasher: &mut Sha256, len: usize) {
+    hasher.update((len as u64).to_le_bytes());
+}
+
+fn update_str(hasher: &mut Sha256, value: &str) {
+    update_len(hasher, value.len());
+    hasher.update(value.as_bytes());
+}
+
+/// A TTL-based on-disk cache of instance discovery and backend listing results.
+///
+/// There is one cache file per account, named from a SHA-256 digest of the account's API URL,
+/// API key and pinned instance so the key itself is never written to disk.
+#[derive(Clone, Debug)]
+pub(crate) struct DiscoveryCache {
+    path: PathBuf,
+    ttl: Duration,
+}
+
+impl DiscoveryCache {
+    pub fn new(account: &AccountEntry, ttl: Duration) -> Option<Self> {
+        let mut hasher = Sha256::new();
+        update_str(&mut hasher, &account.url);
+        update_str(&mut hasher, &account.token);
+        match &account.instance {
+            Some(instance) => {
+                hasher.update([1]);
+                update_str(&mut hasher, instance);
+            }
+            None => hasher.update([0]),
+        }
+        let digest = hasher.finalize();
+        let name: String = digest.iter().map(|byte| format!("{:02x}", byte)).collect();
+        let path = cache_dir()?.join(format!("discovery-{}.json", name));
+        Some(DiscoveryCache { path, ttl })
+    }
+
+    pub fn is_fresh(&self, created: SystemTime) -> bool {
+        match SystemTime::now().duration_since(created) {
+            Ok(age) => age < self.ttl,
+            // The cache was written "in the future", so the clock moved; don't trust it.
+            Err(_) => false,
+        }
+    }
+
+    /// Load the cached discovery results, if present, current and not expired.
+    pub fn load(&self) -> Option<CachedDiscovery> {
+        let file: DiscoveryCacheFile = read_json(&self.path)?;
+        if file.version != DISCOVERY_CACHE_VERSION {
+            return None;
+        }
+        let created = UNIX_EPOCH + Duration::from_secs(file.created);
+        if !self.is_fresh(created) {
+            log_debug(&format!("Discovery cache expired: {}", self.path.display()));
+            return None;
+        }
+        let instances: Vec<Instance> = file
+            .instances
+            .into_iter()
+            .map(|x| Instance {
+                crn: CString::new(x.crn).unwrap(),
+                name: CString::new(x.name).unwrap(),
+            })
+            .collect();
+        let mut listing = Vec::with_capacity(file.backends.len());
+        for backend in file.backends {
+            let instance = instances
+                .iter()
+                .find(|x| x.crn.to_str().unwrap() == backend.instance_crn)?;
+            listing.push((instance.clone(), backend.device));
+        }
+        log_debug(&format!("Loaded discovery cache: {}", self.path.display()));
+        Some(CachedDiscovery {
+            created,
+            instances,
+            listing,
+        })
+    }
+
+    pub fn store(&self, instances: &[Instance], listing: &BackendListing) {
+        let file = DiscoveryCacheFile {
+            version: DISCOVERY_CACHE_VERSION,
+            created: unix_seconds(SystemTime::now()),
+            instances: instances
+                .iter()
+                .map(|x| CachedInstance {
+                    crn: x.crn.to_str().unwrap().to_string(),
+                    name: x.name.to_str().unwrap().to_string(),
+                })
+                .collect(),
+            backends: listing
+                .iter()
+                .map(|(instance, device)| CachedBackend {
+                    instance_crn: instance.crn.to_str().unwrap().to_string(),
+                    device: device.clone(),
+                })
+                .collect(),
+        };
+        if let Err(e) = write_json_atomic(&self.path, &file) {
+            log_warn(&format!(
+                "Failed to write discovery cache {}: {}",
+                self.path.display(),
+                e
+            ));
+        }
+    }
+
+    pub fn clear(&self) {
+        match std::fs::remove_file(&self.path) {
+            Ok(()) => (),
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => (),
+            Err(e) => log_warn(&format!(
+                "Failed to remove discovery cache {}: {}",
+                self.path.display(),
+                e
+            )),
+        }
+    }
+}
+
+#[derive(Deserialize, Serialize)]
+struct TargetCacheFile {
+    version: u32,
+    checked: u64,
+    data: TargetData,
+}
+
+#[derive(Debug)]
+struct CachedTarget {
+    /// What the target was built from. Its calibration is always known.
+    data: Arc<TargetData>,
+    checked: SystemTime,
+    /// When the entry was last handed out, for eviction.
+    used: Instant,
+    target: Target,
+}
+
+/// What was taken from a cached target (usually a copy of it), with the data it was built from.
+pub(crate) struct TargetCacheHit<T> {
+    pub target: T,
+    pub data: Arc<TargetData>,
+    /// Whether the calibration was checked within [TARGET_REVALIDATE_INTERVAL].
+    pub fresh: bool,
+}
+
+/// Built targets, kept in memory and on disk, keyed by backend name and calibration.
+///
+/// A target is only valid for the calibration (the properties' ``last_update_date``) it was
+/// built from. Callers check the calibration once the entry is no longer fresh and replace
+/// the entry when it has moved. Callers take what they need from the cached target, usually a
+/// copy with [Target::copy], so it is never shared; callers that only need the data take
+/// nothing and skip the copy.
+///
+/// Only so many targets are kept in memory; past that the least recently used are dropped,
+/// and are loaded again from disk when next needed.
+#[derive(Clone, Debug, Default)]
+pub(crate) struct TargetCache {
+    dir: Option<PathBuf>,
+    entries: Arc<Mutex<HashMap<String, CachedTarget>>>,
+    // The most entries kept in memory, or 0 for no limit.
+    capacity: Arc<AtomicUsize>,
+    // One lock per backend, held while its target is looked up or fetched.
+    fetches: Arc<Mutex<HashMap<String, Arc<tokio::sync::Mutex<()>>>>>,
+}
+
+impl TargetCache {
+    pub fn new() -> Self {
+        TargetCache {
+            dir: cache_dir().map(|dir| dir.join("targets")),
+            capacity: Arc::new(AtomicUsize::new(DEFAULT_TARGET_CACHE_CAPACITY)),
+            ..Default::default()
+        }
+    }
+
+    /// Keep at most `capacity` targets in memory, or any number if 0.
+    pub fn set_capacity(&self, capacity: usize) {
+        self.capacity.store(capacity, Ordering::Relaxed);
+        self.evict(&mut self.entries.lock().unwrap(), None);
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.capacity.load(Ordering::Relaxed)
+    }
+
+    /// Drop the least recently used entries, other than `keep`, until the capacity is met.
+    fn evict(&self, entries: &mut HashMap<String, CachedTarget>, keep: Option<&str>) {
+        let capacity = self.capacity();
+        while capacity > 0 && entries.len() > capacity {
+            let Some(oldest) = entries
+                .iter()
+                .filter(|(name, _)| Some(name.as_str()) != keep)
+                .min_by_key(|(_, entry)| entry.used)
+                .map(|(name, _)| name.clone())
+            else {
+                return;
+            };
+            log_debug(&format!("Evicted the cached target of {}", oldest));
+            entries.remove(&oldest);
+        }
+    }
+
+    /// The lock to hold while looking up or fetching the target of `backend`, so that
+    /// concurrent requests for the same backend, such as a prefetch and a caller, share one
+    /// fetch.
+    pub fn fetch_lock(&self, backend: &str) -> Arc<tokio::sync::Mutex<()>> {
+        self.fetches
+            .lock()
+            .unwrap()
+            .entry(backend.to_string())
+            .or_default()
+            .clone()
+    }
+
+    /// A cache that is never written to disk.
+    #[cfg(test)]
+    pub fn in_memory() -> Self {
+        TargetCache::default()
+    }
+
+    fn path(&self, backend: &str) -> Option<PathBuf> {
+        Some(self.dir.as_ref()?.join(format!("{}.json", backend)))
+    }
+
+    pub fn get<T>(
+        &self,
+        backend: &str,
+        take: impl FnOnce(&Target) -> T,
+    ) -> Option<TargetCacheHit<T>> {
+        let mut entries = self.entries.lock().unwrap();
+        if !entries.contains_key(backend) {
+            // Read and build the target without holding up lookups of other backends. Callers
+            // hold the fetch lock of `backend`, so it is only loaded once.
+            drop(entries);
+            let entry = self.load(backend)?;
+            entries = self.entries.lock().unwrap();
+            entries.entry(backend.to_string()).or_insert(entry);
+            self.evict(&mut entries, Some(backend));
+        }
+        let entry = entries.get_mut(backend).unwrap();
+        entry.used = Instant::now();
+        let fresh = SystemTime::now()
+            .duration_since(entry.checked)
+            .is_ok_and(|age| age < TARGET_REVALIDATE_INTERVAL);
+        Some(TargetCacheHit {
+            target: take(&entry.target),
+            data: entry.data.clone(),
+            fresh,
+        })
+    }
+
+    fn load(&self, backend: &str) -> Option<CachedTarget> {
+        let path = self.path(backend)?;
+        let file: TargetCacheFile = read_json(&path)?;
+        if file.version != TARGET_CACHE_VERSION || file.data.calibration.is_none() {
+            return None;
+        }
+        log_debug(&format!("Loaded target cache: {}", path.display()));
+        Some(CachedTarget {
+            target: file.data.build(),
+            data: Arc::new(file.data),
+            checked: UNIX_EPOCH + Duration::from_secs(file.checked),
+            used: Instant::now(),
+        })
+    }
+
+    /// Record that the cached calibration of `backend` is still current.
+    pub fn mark_checked(&self, backend: &str) {
+        if let Some(entry) = self.entries.lock().unwrap().get_mut(backend) {
+            entry.checked = SystemTime::now();
+        }
+    }
+
+    /// The backends with a target in memory.
+    #[cfg(test)]
+    pub fn backends_in_memory(&self) -> Vec<String> {
+        let mut names: Vec<String> = self.entries.lock().unwrap().keys().cloned().collect();
+        names.sort();
+        names
+    }
+
+    /// Make the entry of `backend` due for a calibration check.
+    #[cfg(test)]
+    pub fn expire(&self, backend: &str) {
+        if let Some(entry) = self.entries.lock().unwrap().get_mut(backend) {
+            entry.checked = UNIX_EPOCH;
+        }
+    }
+
+    /// Build the target of `backend` from `data`, cache it if the calibration is known, and
+    /// return what `take` takes from it.
+    pub fn insert<T>(
+        &self,
+        backend: &str,
+        data: TargetData,
+        take: impl FnOnce(&Target) -> T,
+    ) -> (T, Arc<TargetData>) {
+        let target = data.build();
+        if data.calibration.is_none() {
+            return (take(&target), Arc::new(data));
+        }
+        let now = SystemTime::now();
+        if let Some(path) = self.path(backend) {
+            let file = TargetCacheFile {
+                version: TARGET_CACHE_VERSION,
+                checked: unix_seconds(now),
+                data,
+            };
+            if let Err(e) = write_json_atomic(&path, &file) {
+                log_warn(&format!(
+                    "Failed to write target cache {}: {}",
+                    path.display(),
+                    e
+                ));
+            }
+            return self.insert_entry(backend, target, file.data, now, take);
+        }
+        self.insert_entry(backend, target, data, now, take)
+    }
+
+    fn insert_entry<T>(
+        &self,
+        backend: &str,
+        target: Target,
+        data: TargetData,
+        checked: SystemTime,
+        take: impl FnOnce(&Target) -> T,
+    ) -> (T, Arc<TargetData>) {
+        let data = Arc::new(data);
+        let taken = take(&target);
+        let mut entries = self.entries.lock().unwrap();
+        entries.insert(
+            backend.to_string(),
+            CachedTarget {
+                data: data.clone(),
+                checked,
+                used: Instant::now(),
+                target,
+            },
+        );
+        self.evict(&mut entries, Some(backend));
+        (taken, data)
+    }
+}
+
+/// Transpiled circuits, kept on disk as QPY and keyed by [TranspileCache::key].
+///
+/// The transpiler places circuits by the errors of the backend's qubits, so a circuit is only
+/// cached against a known calibration and is transpiled again once the calibration moves.
+/// Only the circuit is kept, not the layout of the transpilation. Each file starts with its key,
+/// which is checked on load, and the least recently used files are removed once the directory
+/// grows past [TRANSPILE_CACHE_MAX_BYTES].
+#[derive(Clone, Debug)]
+pub(crate) struct TranspileCache {
+    dir: Option<PathBuf>,
+    max_bytes: u64,
+}
+
+/// A SHA-256 digest identifying a transpilation, see [TranspileCache::key].
+pub(crate) type TranspileKey = [u8; 32];
+
+impl Default for TranspileCache {
+    fn default() -> Self {
+        TranspileCache {
+            dir: None,
+            max_bytes: TRANSPILE_CACHE_MAX_BYTES,
+        }
+    }
+}
+
+impl TranspileCache {
+    pub fn new() -> Self {
+        TranspileCache {
+            dir: cache_dir().map(|dir| dir.join("transpiled")),
+            ..Default::default()
+        }
+    }
+
+    /// A digest of the structure of a circuit, with its parameters, together with the backend,
+    /// its calibration and the transpiler options.
+    ///
+    /// Every field is written in a fixed little-endian encoding, with lengths before strings and
+    /// slices, so the key is the same across builds and platforms.
+    pub fn key<'a>(
+        num_qubits: u32,
+        num_clbits: u32,
+        instructions: impl Iterator<Item = CircuitInstruction<'a>>,
+        backend: &str,
+        calibration: &str,
+        options: &QkTranspileOptions,
+    ) -> TranspileKey {
+        fn update_bits(hasher: &mut Sha256, bits: &[u32]) {
+            update_len(hasher, bits.len());
+            for bit in bits {
+                hasher.update(bit.to_le_bytes());
+            }
+        }
+
+        let mut hasher = Sha256::new();
+        hasher.update(TRANSPILE_CACHE_VERSION.to_le_bytes());
+        update_str(&mut hasher, backend);
+        update_str(&mut hasher, calibration);
+        hasher.update(options.optimization_level.to_le_bytes());
+        hasher.update(options.seed.to_le_bytes());
+        hasher.update(options.approximation_degree.to_le_bytes());
+        hasher.update(num_qubits.to_le_bytes());
+        hasher.update(num_clbits.to_le_bytes());
+        for inst in instructions {
+            update_str(&mut hasher, &inst.name);
+            update_bits(&mut hasher, inst.qubits);
+            update_bits(&mut hasher, inst.clbits);
+            update_len(&mut hasher, inst.params.len());
+            for param in inst.params {
+                hasher.update(param.to_le_bytes());
+            }
+        }
+        hasher.finalize().into()
+    }
+
+    fn path(&self, backend: &str, key: &TranspileKey) -> Option<PathBuf> {
+        let name: String = key.iter().map(|byte| format!("{:02x}", byte)).collect();
+        Some(
+            self.dir
+                .as_ref()?
+                .join(backend)
+                .join(format!("{}.qpy", name)),
+        )
+    }
+
+    /// The QPY payload stored at `path`, if the file was written for `key`.
+    fn read(path: &Path, key: &TranspileKey) -> Option<Vec<u8>> {
+        let mut payload = std::fs::read(path).ok()?;
+        if !payload.starts_with(key) {
+            log_warn(&format!(
+                "Ignoring transpiled circuit {} written for another key",
+                path.display()
+            ));
+            return None;
+        }
+        payload.drain(..key.len());
+        Some(payload)
+    }
+
+    /// The cached circuit for `key`, owned by the caller.
+    pub fn get(&self, backend: &str, key: &TranspileKey) -> Option<Circuit> {
+        let path = self.path(backend, key)?;
+        let payload = Self::read(&path, key)?;
+        let Some(decoded) = decode_qpy(&payload) else {
+            log_warn(&format!(
+                "Ignoring unreadable transpiled circuit {}",
+                path.display()
+            ));
+            return None;
+        };
+        let mut circuit = Circuit::new(decoded.num_qubits, decoded.num_clbits);
+        for inst in &decoded.instructions {
+            if !circuit.append(inst.name, &inst.qubits, &inst.clbits, &inst.params) {
+                log_warn(&format!(
+                    "Ignoring invalid transpiled circuit {}",
+                    path.display()
+                ));
+                unsafe { qiskit_ffi::qk_circuit_free(circuit.0) };
+                return None;
+            }
+        }
+        // Mark the file as used so eviction removes colder circuits first.
+        let _ = File::options()
+            .write(true)
+            .open(&path)
+            .and_then(|file| file.set_modified(SystemTime::now()));
+        log_debug(&format!("Loaded transpiled circuit: {}", path.display()));
+        Some(circuit)
+    }
+
+    pub fn insert(&self, backend: &str, key: &TranspileKey, circuit: &Circuit) {
+        let Some(path) = self.path(backend, key) else {
+            return;
+        };
+        let payload = match encode_qpy_verbatim(
+            circuit.num_qubits(),
+            circuit.num_clbits(),
+            circuit.get_circuit_instructions(),
+        ) {
+            Ok(payload) => payload,
+            Err(e) => {
+                log_warn(&format!("Failed to encode transpiled circuit: {}", e));
+                return;
+            }
+        };
+        if let Err(e) = write_atomic(&path, |writer| {
+            std::io::Write::write_all(writer, key)?;
+            std::io::Write::write_all(writer, &payload)
+        }) {
+            log_warn(&format!(
+                "Failed to write transpiled circuit {}: {}",
+                path.display(),
+                e
+            ));
+            return;
+        }
+        self.evict();
+    }
+
+    /// Remove the least recently used files until the cache fits in `max_bytes`.
+    fn evict(&self) {
+        let Some(dir) = self.dir.as_ref() else {
+            return;
+        };
+        let Ok(backends) = std::fs::read_dir(dir) else {
+            return;
+        };
+        let mut files = Vec::new();
+        let mut total = 0;
+        for backend in backends.flatten() {
+            let Ok(entries) = std::fs::read_dir(backend.path()) else {
+                continue;
+            };
+            for entry in entries.flatten() {
+                let path = entry.path();
+                if path.extension().map_or(true, |ext| ext != "qpy") {
+                    continue;
+                }
+                let Ok(metadata) = entry.metadata() else {
+                    continue;
+                };
+                total += metadata.len();
+                let used = metadata.modified().unwrap_or(UNIX_EPOCH);
+                files.push((used, metadata.len(), path));
+            }
+        }
+        if total <= self.max_bytes {
+            return;
+        }
+        files.sort_unstable_by_key(|(used, _, _)| *used);
+        for (_, len, path) in files {
+            if total <= self.max_bytes {
+                break;
+            }
+            match std::fs::remove_file(&path) {
+                Ok(()) => {
+                    log_debug(&format!("Evicted transpiled circuit: {}", path.display()));
+                    total -= len;
+                }
+                Err(e) => log_warn(&format!(
+                    "Failed to evict transpiled circuit {}: {}",
+                    path.display(),
+                    e
+                )),
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    type Gates<'a> = [(&'a str, &'a [u32], &'a [f64])];
+
+    fn key(circuit: &Gates, calibration: &str, options: &QkTranspileOptions) -> TranspileKey {
+        let instructions = circuit
+            .iter()
+            .map(|&(name, qubits, params)| CircuitInstruction {
+                name: name.to_string(),
+                qubits,
+                clbits: &[],
+                params,
+            });
+        TranspileCache::key(2, 0, instructions, "ibm_heron", calibration, options)
+    }
+
+    #[test]
+    fn transpile_key_covers_circuit_backend_and_options() {
+        let options = QkTranspileOptions {
+            optimization_level: 2,
+            seed: 7,
+            approximation_degree: 1.,
+        };
+        let circuit: &Gates = &[("h", &[0], &[]), ("rzz", &[0, 1], &[0.5])];
+        let base = key(circuit, "2025-06-01", &options);
+        assert_eq!(base, key(circuit, "2025-06-01", &options));
+        assert_ne!(base, key(circuit, "2025-06-02", &options));
+        for seed in [-1, 8] {
+            let options = QkTranspileOptions { seed, ..options };
+            assert_ne!(base, key(circuit, "2025-06-01", &options));
+        }
+        let changed: [&Gates; 3] = [
+            &[("h", &[1], &[]), ("rzz", &[0, 1], &[0.5])],
+            &[("h", &[0], &[]), ("rzz", &[0, 1], &[0.25])],
+            &[("h", &[0], &[]), ("rzz", &[1, 0], &[0.5])],
+        ];
+        for circuit in changed {
+            assert_ne!(base, key(circuit, "2025-06-01", &options));
+        }
+    }
+
+    #[test]
+    fn transpile_key_is_stable() {
+        let options = QkTranspileOptions {
+            optimization_level: 2,
+            seed: 7,
+            approximation_degree: 1.,
+        };
+        let circuit: &Gates = &[("h", &[0], &[]), ("rzz", &[0, 1], &[0.5])];
+        let name: String = key(circuit, "2025-06-01", &options)
+            .iter()
+            .map(|byte| format!("{:02x}", byte))
+            .collect();
+        assert_eq!(
+            name,
+            "8d992ff40588a99d5855af7012d4130dc427d64400a4f82de3059628be291af8"
+        );
+    }
+
+    fn scratch_dir(name: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("qkrt-{}-{}", name, std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(&dir).unwrap();
+        dir
+    }
+
+    #[test]
+    fn transpile_cache_checks_key_on_load() {
+        let dir = scratch_dir("transpile-key");
+        let path = dir.join("circuit.qpy");
+        let key = [1; 32];
+        std::fs::write(&path, [&key[..], b"QISKIT"].concat()).unwrap();
+        assert_eq!(
+            TranspileCache::read(&path, &key).as_deref(),
+            Some(&b"QISKIT"[..])
+        );
+        assert_eq!(TranspileCache::read(&path, &[2; 32]), None);
+        std::fs::write(&path, &key[..8]).unwrap();
+        assert_eq!(TranspileCache::read(&path, &key), None);
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn transpile_cache_evicts_least_recently_used() {
+        let dir = scratch_dir("transpile-evict");
+        let cache = TranspileCache {
+            dir: Some(dir.clone()),
+            max_bytes: 250,
+        };
+        let mut paths = Vec::new();
+        for (i, backend) in ["ibm_a", "ibm_b", "ibm_a"].into_iter().enumerate() {
+            std::fs::create_dir_all(dir.join(backend)).unwrap();
+            let path = dir.join(backend).join(format!("{}.qpy", i));
+            std::fs::write(&path, [0; 100]).unwrap();
+            File::options()
+                .write(true)
+                .open(&path)
+                .unwrap()
+                .set_modified(UNIX_EPOCH + Duration::from_secs(1000 + i as u64))
+                .unwrap();
+            paths.push(path);
+        }
+        cache.evict();
+        assert!(!paths[0].exists());
+        assert!(paths[1].exists());
+        assert!(paths[2].exists());
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn discovery_cache_name_separates_account_fields() {
+        let account = |url: &str, token: &str, instance: Option<&str>| -> AccountEntry {
+            serde_json::from_value(serde_json::json!({
+                "channel": "ibm_quantum_platform",
+                "instance": instance,
+                "token": token,
+                "url": url,
+            }))
+            .unwrap()
+        };
+        let path = |account: AccountEntry| {
+            DiscoveryCache::new(&account, Duration::from_secs(60))
+                .unwrap()
+                .path
+        };
+        let base = path(account("https://cloud.ibm.com", "key", None));
+        assert_eq!(base, path(account("https://cloud.ibm.com", "key", None)));
+        // A field boundary moved, or an empty instance pinned, must not reuse the file.
+        assert_ne!(base, path(account("https://cloud.ibm.co", "mkey", None)));
+        assert_ne!(
+            base,
+            path(account("https://cloud.ibm.com", "key", Some("")))
+        );
+        let name = base.file_name().unwrap().to_str().unwrap();
+        assert!(!name.contains("key"));
+        assert_eq!(name.len(), "discovery-.json".len() + 64);
+    }
+}
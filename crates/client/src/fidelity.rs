@@ -0,0 +1,204 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Estimated success probability (ESP) of a circuit on a backend.
+//!
+//! The ESP is the product of ``1 - error`` over every instruction of the circuit, using the
+//! errors the backend reports for each instruction on its qubits. It is summed as logarithms,
+//! so long circuits don't lose precision to repeated multiplication.
+
+use std::collections::HashMap;
+
+use crate::backend_data::TargetData;
+use crate::qiskit_circuit::CircuitInstruction;
+use crate::qiskit_target::ISAGate;
+
+#[derive(Copy, Clone, Debug, PartialEq, Eq, Hash)]
+pub(crate) enum Operation {
+    Gate(ISAGate),
+    Measure,
+    Reset,
+}
+
+impl Operation {
+    pub fn from_name(name: &str) -> Option<Self> {
+        match name {
+            "measure" => Some(Operation::Measure),
+            "reset" => Some(Operation::Reset),
+            name => ISAGate::from_name(name).map(Operation::Gate),
+        }
+    }
+}
+
+/// An operation and its qubits. The second qubit of a single-qubit operation is `u32::MAX`.
+type OperationKey = (Operation, u32, u32);
+
+fn key(operation: Operation, qubits: &[u32]) -> Option<OperationKey> {
+    match *qubits {
+        [a] => Some((operation, a, u32::MAX)),
+        [a, b] => Some((operation, a, b)),
+        _ => None,
+    }
+}
+
+/// ``ln(1 - error)`` and the duration of every instruction a backend supports.
+#[derive(Debug, Default)]
+pub(crate) struct FidelityIndex(HashMap<OperationKey, (f64, Option<f64>)>);
+
+impl FidelityIndex {
+    /// An instruction without a reported error is taken to be perfect.
+    pub fn new(data: &TargetData) -> Self {
+        let entry = |[duration, error]: [Option<f64>; 2]| {
+            ((-error.unwrap_or(0.).clamp(0., 1.)).ln_1p(), duration)
+        };
+        let gates = data.gates.iter().flat_map(|(gate, props)| {
+            props.iter().filter_map(move |(qargs, props)| {
+                Some((key(Operation::Gate(*gate), qargs)?, entry(*props)))
+            })
+        });
+        let single = |operation, entries: &[(u32, [Option<f64>; 2])]| {
+            entries
+                .iter()
+                .map(move |(qubit, props)| ((operation, *qubit, u32::MAX), entry(*props)))
+                .collect::<Vec<_>>()
+        };
+        FidelityIndex(
+            gates
+                .chain(single(Operation::Measure, &data.measure))
+                .chain(single(Operation::Reset, &data.reset))
+                .collect(),
+        )
+    }
+
+    /// Whether the backend supports `operation` on `qubits`.
+    pub fn supports(&self, operation: Operation, qubits: &[u32]) -> bool {
+        key(operation, qubits).is_some_and(|key| self.0.contains_key(&key))
+    }
+
+    /// The duration the backend reports for `operation` on `qubits`, in seconds.
+    pub fn duration(&self, operation: Operation, qubits: &[u32]) -> Option<f64> {
+        self.0.get(&key(operation, qubits)?)?.1
+    }
+}
+
+/// The instructions of a circuit reduced to what their errors depend on, so a circuit read once
+/// can be scored against many backends.
+#[derive(Debug, Default)]
+pub(crate) struct CircuitOperations {
+    /// `None` for an instruction no backend can run as is.
+    operations: Vec<Option<OperationKey>>,
+}
+
+impl CircuitOperations {
+    /// Barriers are skipped, as they have no error.
+    pub fn new<'a>(instructions: impl Iterator<Item = CircuitInstruction<'a>>) -> Self {
+        let operations = instructions
+            .filter(|inst| inst.name != "barrier")
+            .map(|inst| key(Operation::from_name(&inst.name)?, inst.qubits))
+            .collect();
+        CircuitOperations { operations }
+    }
+
+    /// The logarithm of the ESP on the backend of `data`. An instruction the backend doesn't
+    /// support on its qubits can't succeed, so gives negative infinity.
+    pub fn log_success_probability(&self, data: &TargetData) -> f64 {
+        let index = &data.fidelity_index().0;
+        self.operations
+            .iter()
+            .map(|op| {
+                op.and_then(|op| index.get(&op))
+                    .map_or(f64::NEG_INFINITY, |(log_fidelity, _)| *log_fidelity)
+            })
+            .sum()
+    }
+
+    /// The ESP on each of the backends of `data`, computed on up to one thread per core.
+    pub fn success_probabilities(&self, data: &[&TargetData]) -> Vec<f64> {
+        let threads = std::thread::available_parallelism().map_or(1, |n| n.get());
+        let chunk = data.len().div_ceil(threads).max(1);
+        let mut out = vec![0.; data.len()];
+        std::thread::scope(|scope| {
+            for (data, out) in data.chunks(chunk).zip(out.chunks_mut(chunk)) {
+                scope.spawn(move || {
+                    for (data, out) in data.iter().zip(out) {
+                        *out = self.log_success_probability(data).exp();
+                    }
+                });
+            }
+        });
+        out
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn inst<'a>(name: &str, qubits: &'a [u32]) -> CircuitInstruction<'a> {
+        CircuitInstruction {
+            name: name.to_string(),
+            qubits,
+            clbits: &[],
+            params: &[],
+        }
+    }
+
+    #[test]
+    fn success_probability_multiplies_fidelities() {
+        let data = TargetData {
+            num_qubits: 2,
+            gates: vec![
+                (ISAGate::SX, vec![(vec![0], [None, Some(1e-3)])]),
+                (ISAGate::RZ, vec![(vec![0], [None, None])]),
+                (ISAGate::CZ, vec![(vec![0, 1], [None, Some(1e-2)])]),
+            ],
+            measure: vec![(0, [None, Some(0.02)]), (1, [None, Some(0.05)])],
+            ..Default::default()
+        };
+        let circuit = CircuitOperations::new(
+            [
+                inst("sx", &[0]),
+                inst("rz", &[0]),
+                inst("sx", &[0]),
+                inst("cz", &[0, 1]),
+                inst("barrier", &[0, 1]),
+                inst("measure", &[0]),
+                inst("measure", &[1]),
+            ]
+            .into_iter(),
+        );
+        let expected = 0.999f64.powi(2) * 0.99 * 0.98 * 0.95;
+        let esp = circuit.log_success_probability(&data).exp();
+        assert!((esp - expected).abs() < 1e-12, "{} != {}", esp, expected);
+
+        // CZ is only supported in one direction, and X not at all.
+        for unsupported in [inst("cz", &[1, 0]), inst("x", &[0]), inst("h", &[0])] {
+            let circuit = CircuitOperations::new([unsupported].into_iter());
+            assert_eq!(circuit.log_success_probability(&data), f64::NEG_INFINITY);
+        }
+
+        let better = TargetData {
+            num_qubits: 2,
+            gates: vec![
+                (ISAGate::SX, vec![(vec![0], [None, Some(1e-4)])]),
+                (ISAGate::RZ, vec![(vec![0], [None, None])]),
+                (ISAGate::CZ, vec![(vec![0, 1], [None, Some(1e-3)])]),
+            ],
+            measure: vec![(0, [None, Some(0.01)]), (1, [None, Some(0.01)])],
+            ..Default::default()
+        };
+        let batch = circuit.success_probabilities(&[&data, &better, &TargetData::default()]);
+        assert!((batch[0] - expected).abs() < 1e-12);
+        assert!(batch[1] > batch[0]);
+        assert_eq!(batch[2], 0.);
+    }
+}
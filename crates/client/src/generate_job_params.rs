@@ -12,19 +12,74 @@
 
 use crate::generate_qpy;
 use crate::qiskit_circuit;
+use binrw::BinResult;
 use flate2::write::ZlibEncoder;
 use flate2::Compression;
 use std::io::prelude::*;
+use std::io::BufWriter;
+
+/// The size of the buffer in front of the compressor, so the many small writes of the QPY
+/// fields reach it in blocks.
+const COMPRESS_BUFFER_SIZE: usize = 64 * 1024;
+
+/// Base64-encodes what is written to it as it arrives, holding back at most the two bytes that
+/// don't yet make up a group of three.
+#[derive(Default)]
+struct Base64Writer {
+    pending: Vec<u8>,
+    encoded: String,
+}
+
+impl Base64Writer {
+    fn finish(mut self) -> String {
+        base64_simd::STANDARD.encode_append(&self.pending, &mut self.encoded);
+        self.encoded
+    }
+}
+
+impl Write for Base64Writer {
+    fn write(&mut self, mut buf: &[u8]) -> std::io::Result<usize> {
+        let len = buf.len();
+        if !self.pending.is_empty() {
+            let take = (3 - self.pending.len()).min(buf.len());
+            self.pending.extend_from_slice(&buf[..take]);
+            buf = &buf[take..];
+            if self.pending.len() < 3 {
+                return Ok(len);
+            }
+            base64_simd::STANDARD.encode_append(&self.pending, &mut self.encoded);
+            self.pending.clear();
+        }
+        let whole = buf.len() - buf.len() % 3;
+        base64_simd::STANDARD.encode_append(&buf[..whole], &mut self.encoded);
+        self.pending.extend_from_slice(&buf[whole..]);
+        Ok(len)
+    }
+
+    fn flush(&mut self) -> std::io::Result<()> {
+        Ok(())
+    }
+}
+
+type PayloadWriter = BufWriter<ZlibEncoder<Base64Writer>>;
+
+/// Compress and base64-encode the QPY `write_qpy` writes, as it writes it, so neither the QPY
+/// nor the compressed QPY is ever held in full.
+fn encode_payload(
+    write_qpy: impl FnOnce(PayloadWriter) -> BinResult<PayloadWriter>,
+) -> std::io::Result<String> {
+    let compress = ZlibEncoder::new(Base64Writer::default(), Compression::default());
+    let writer = write_qpy(BufWriter::with_capacity(COMPRESS_BUFFER_SIZE, compress))
+        .map_err(|e| std::io::Error::other(e.to_string()))?;
+    let compress = writer.into_inner().map_err(|e| e.into_error())?;
+    Ok(compress.finish()?.finish())
+}
 
 pub fn generate_single_pubs_payload(
     circuit: &qiskit_circuit::Circuit,
 ) -> Vec<ibm_quantum_platform_api::models::SamplerV2InputPubsInner> {
-    let base64 = base64_simd::STANDARD;
-    let qpy = generate_qpy::generate_qpy_payload(circuit).unwrap();
-    let mut compress = ZlibEncoder::new(Vec::new(), Compression::default());
-    compress.write_all(&qpy).unwrap();
-    let compressed_qpy = compress.finish().unwrap();
-    let encoded_circuit = base64.encode_to_string(compressed_qpy);
+    let encoded_circuit =
+        encode_payload(|writer| generate_qpy::write_circuit_qpy(circuit, writer)).unwrap();
     vec![ibm_quantum_platform_api::models::SamplerV2InputPubsInner::new(encoded_circuit)]
 }
 
@@ -61,3 +116,139 @@ pub fn create_sampler_job_payload(
         version: 2,
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::generate_qpy::encode_qpy;
+    use crate::qiskit_circuit::CircuitInstruction;
+    use std::time::Instant;
+
+    /// The payload as it was built before it was streamed, from the whole QPY and the whole
+    /// compressed QPY.
+    fn buffered_payload(qpy: &[u8]) -> String {
+        let mut compress = ZlibEncoder::new(Vec::new(), Compression::default());
+        compress.write_all(qpy).unwrap();
+        base64_simd::STANDARD.encode_to_string(compress.finish().unwrap())
+    }
+
+    /// An ISA circuit shaped like the transpiled fe4s4 LUCJ sample: `layers` layers of
+    /// single-qubit rotations and a brickwork of CZs on its 72 qubits, then a measurement of
+    /// each.
+    fn lucj_sized_circuit(layers: usize) -> Vec<(String, Vec<u32>, Vec<u32>, Vec<f64>)> {
+        let mut instructions = Vec::new();
+        for layer in 0..layers {
+            for q in 0..72u32 {
+                let angle = (layer * 72 + q as usize) as f64 * 0.618;
+                instructions.push(("rz".to_string(), vec![q], vec![], vec![angle]));
+                instructions.push(("sx".to_string(), vec![q], vec![], vec![]));
+                instructions.push(("rz".to_string(), vec![q], vec![], vec![-angle]));
+            }
+            for q in (layer as u32 % 2..71).step_by(2) {
+                instructions.push(("cz".to_string(), vec![q, q + 1], vec![], vec![]));
+            }
+        }
+        for q in 0..72u32 {
+            instructions.push(("measure".to_string(), vec![q], vec![q], vec![]));
+        }
+        instructions
+    }
+
+    fn write_circuit<W: Write>(
+        instructions: &[(String, Vec<u32>, Vec<u32>, Vec<f64>)],
+        writer: W,
+    ) -> BinResult<W> {
+        encode_qpy(writer, 72, 72, || {
+            instructions
+                .iter()
+                .map(|(name, qubits, clbits, params)| CircuitInstruction {
+                    name: name.clone(),
+                    qubits,
+                    clbits,
+                    params,
+                })
+        })
+    }
+
+    #[test]
+    fn streamed_payload_matches_buffered() {
+        let instructions = lucj_sized_circuit(3);
+        let qpy = write_circuit(&instructions, Vec::new()).unwrap();
+        let streamed = encode_payload(|writer| write_circuit(&instructions, writer)).unwrap();
+        assert_eq!(streamed, buffered_payload(&qpy));
+
+        // Writes of every size leave the same groups of three to encode.
+        let data: Vec<u8> = (0..=255).collect();
+        for chunk in 1..8 {
+            let mut writer = Base64Writer::default();
+            for part in data[..data.len() - chunk].chunks(chunk) {
+                writer.write_all(part).unwrap();
+            }
+            assert_eq!(
+                writer.finish(),
+                base64_simd::STANDARD.encode_to_string(&data[..data.len() - chunk])
+            );
+        }
+    }
+
+    /// A memory figure of this process, in KiB, from `/proc/self/status`.
+    fn memory_kib(field: &str) -> u64 {
+        let status = std::fs::read_to_string("/proc/self/status").unwrap();
+        let line = status.lines().find(|line| line.starts_with(field)).unwrap();
+        line.split_whitespace().nth(1).unwrap().parse().unwrap()
+    }
+
+    /// Run `f`, returning its output, how long it took and how far it raised the resident
+    /// memory above where it started, in KiB. Resetting the peak needs Linux.
+    fn measure(f: impl FnOnce() -> String) -> (String, std::time::Duration, u64) {
+        std::fs::write("/proc/self/clear_refs", "5").unwrap();
+        let start_rss = memory_kib("VmRSS:");
+        let start = Instant::now();
+        let payload = f();
+        let elapsed = start.elapsed();
+        (
+            payload,
+            elapsed,
+            memory_kib("VmHWM:").saturating_sub(start_rss),
+        )
+    }
+
+    /// Compare building the payload of a large circuit shaped like the fe4s4 LUCJ sample from
+    /// the whole QPY and compressed QPY with streaming it.
+    ///
+    /// Run alone, on Linux, with
+    /// ``cargo test --release -- --ignored --nocapture bench_payload_encoding``.
+    #[test]
+    #[ignore]
+    #[allow(clippy::print_stderr)]
+    fn bench_payload_encoding() {
+        let instructions = lucj_sized_circuit(2000);
+        let qpy_len = write_circuit(&instructions, Vec::new()).unwrap().len();
+
+        let (buffered, buffered_time, buffered_rss) =
+            measure(|| buffered_payload(&write_circuit(&instructions, Vec::new()).unwrap()));
+        let (streamed, streamed_time, streamed_rss) =
+            measure(|| encode_payload(|writer| write_circuit(&instructions, writer)).unwrap());
+        assert_eq!(buffered, streamed);
+
+        let throughput = |time: std::time::Duration| qpy_len as f64 / time.as_secs_f64() / 1e6;
+        eprintln!(
+            "{} instructions, {} bytes of QPY, {} of payload",
+            instructions.len(),
+            qpy_len,
+            streamed.len()
+        );
+        eprintln!(
+            "buffered: {:?}, {:.1} MB/s of QPY, peak RSS +{} KiB",
+            buffered_time,
+            throughput(buffered_time),
+            buffered_rss
+        );
+        eprintln!(
+            "streamed: {:?}, {:.1} MB/s of QPY, peak RSS +{} KiB",
+            streamed_time,
+            throughput(streamed_time),
+            streamed_rss
+        );
+    }
+}
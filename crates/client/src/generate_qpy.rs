@@ -10,25 +10,227 @@
 // copyright notice, and modified files need to carry a notice indicating
 // that they have been altered from the originals.
 
+use binrw::io::NoSeek;
 use binrw::{BinResult, BinWrite};
-use std::io::Cursor;
+use std::f64::consts::{FRAC_PI_2, PI, TAU};
+use std::io::{Cursor, Write};
 
-use crate::qiskit_circuit;
+use crate::qiskit_circuit::{self, CircuitInstruction};
 use crate::qpy_formats;
 
+/// Wrap an angle into (-pi, pi], which changes rotations only by a global phase.
+fn wrap_angle(angle: f64) -> f64 {
+    let wrapped = angle - TAU * (angle / TAU).round();
+    if wrapped <= -PI {
+        wrapped + TAU
+    } else {
+        wrapped
+    }
+}
+
+/// Rewrite `rzz(angle)` on `qubits` into gates fractional-gate backends accept, which only
+/// run RZZ with angles in [0, pi/2], calling `emit` with each gate's name, qubits and params.
+///
+/// The target can't express this constraint, so the transpiler may produce any angle. Up to
+/// a global phase, angles beyond pi/2 in magnitude take RZ(pi) on both qubits and a shift by
+/// pi, and negative angles flip sign by conjugating with X on the first qubit.
+fn fold_rzz(angle: f64, qubits: &[u32], mut emit: impl FnMut(&str, &[u32], &[f64])) {
+    let mut angle = wrap_angle(angle);
+    if angle.abs() > FRAC_PI_2 {
+        emit("rz", &qubits[..1], &[PI]);
+        emit("rz", &qubits[1..], &[PI]);
+        angle -= PI.copysign(angle);
+    }
+    if angle == 0. {
+        return;
+    }
+    if angle < 0. {
+        emit("x", &qubits[..1], &[]);
+        emit("rzz", qubits, &[-angle]);
+        emit("x", &qubits[..1], &[]);
+    } else {
+        emit("rzz", qubits, &[angle]);
+    }
+}
+
+/// The instructions of ISA circuits, by name and QPY class name.
+const GATE_CLASSES: [(&str, &str); 12] = [
+    ("x", "XGate"),
+    ("sx", "SXGate"),
+    ("cz", "CZGate"),
+    ("measure", "Measure"),
+    ("reset", "Reset"),
+    ("ecr", "ECRGate"),
+    ("cx", "CXGate"),
+    ("rz", "RZGate"),
+    ("id", "IGate"),
+    ("rx", "RXGate"),
+    ("rzz", "RZZGate"),
+    ("barrier", "Barrier"),
+];
+
+fn pack_instruction(
+    name: &str,
+    qubits: &[u32],
+    clbits: &[u32],
+    params: &[f64],
+) -> qpy_formats::CircuitInstructionV2Pack {
+    let out_name = match GATE_CLASSES.iter().find(|(gate, _)| *gate == name) {
+        Some((_, class)) => *class,
+        None => panic!("Not an ISA circuit {}", name),
+    };
+    let num_ctrl_qubits = if name == "cx" || name == "cz" { 1 } else { 0 };
+    let bit_data: Vec<qpy_formats::CircuitInstructionArgPack> = qubits
+        .iter()
+        .map(|index| qpy_formats::CircuitInstructionArgPack {
+            bit_type: b'q',
+            index: *index,
+        })
+        .chain(
+            clbits
+                .iter()
+                .map(|index| qpy_formats::CircuitInstructionArgPack {
+                    bit_type: b'c',
+                    index: *index,
+                }),
+        )
+        .collect();
+    let params: Vec<qpy_formats::PackedParam> = params
+        .iter()
+        .map(|param| qpy_formats::PackedParam {
+            type_key: b'f',
+            data_len: 8,
+            data: param.to_be_bytes().to_vec(),
+        })
+        .collect();
+    qpy_formats::CircuitInstructionV2Pack {
+        name_size: out_name.len() as u16,
+        label_size: 0,
+        num_parameters: params.len() as u16,
+        num_qargs: qubits.len() as u32,
+        num_cargs: clbits.len() as u32,
+        conditional_key: 0,
+        condition_register_size: 0,
+        condition_value: 0,
+        num_ctrl_qubits,
+        ctrl_state: 1,
+        gate_class_name: out_name.as_bytes().to_vec(),
+        label_raw: Vec::new(),
+        condition_raw: Vec::new(),
+        bit_data,
+        params,
+    }
+}
+
 pub fn generate_qpy_payload(circuit: &qiskit_circuit::Circuit) -> BinResult<Vec<u8>> {
-    // Size estimate is "QISKIT" + File Header + Circuit header + CircuitInstruction * num
-    // instructions
+    // Size estimate is "QISKIT" + File Header + Circuit header + 32 bytes per instruction
     //
-    // This is an under estimate because it doesn't factor in names, bits, or parameters
-    // but it's enough of starting guess to reduce the number of total allocations
-    let size_estimate = 6
-        + std::mem::size_of::<qpy_formats::FileHeaderV14>()
-        + std::mem::size_of::<qpy_formats::QPYFormatV13>()
-        + (circuit.num_instructions()
-            * std::mem::size_of::<qpy_formats::CircuitInstructionV2Pack>());
-    let output = Vec::with_capacity(size_estimate);
-    let mut writer = Cursor::new(output);
+    // This is an under estimate for instructions with parameters or many bits, but it's enough
+    // of starting guess to reduce the number of total allocations
+    let size_estimate = 64 + circuit.num_instructions() * 32;
+    write_circuit_qpy(circuit, Vec::with_capacity(size_estimate))
+}
+
+/// Write `circuit` as QPY to `writer`, rewriting its instructions as [encode_qpy] does.
+pub(crate) fn write_circuit_qpy<W: Write>(
+    circuit: &qiskit_circuit::Circuit,
+    writer: W,
+) -> BinResult<W> {
+    encode_qpy(writer, circuit.num_qubits(), circuit.num_clbits(), || {
+        circuit.get_circuit_instructions()
+    })
+}
+
+/// Call `emit` with each instruction `inst` is written as. RZZ angles are folded into the
+/// range backends accept, and RX angles are wrapped into (-pi, pi].
+fn rewrite_instruction(
+    inst: &CircuitInstruction,
+    mut emit: impl FnMut(&str, &[u32], &[u32], &[f64]),
+) {
+    match inst.name.as_str() {
+        "rzz" => fold_rzz(inst.params[0], inst.qubits, |name, qubits, params| {
+            emit(name, qubits, &[], params)
+        }),
+        "rx" => emit(
+            "rx",
+            inst.qubits,
+            inst.clbits,
+            &[wrap_angle(inst.params[0])],
+        ),
+        name => emit(name, inst.qubits, inst.clbits, inst.params),
+    }
+}
+
+/// Write a circuit with the instructions `instructions` iterates over as QPY to `writer`,
+/// rewriting them with [rewrite_instruction], so the output may have more instructions than
+/// the input.
+///
+/// The instructions are iterated over twice, first to count what they are written as, which
+/// the circuit header needs, then to write them. Only one instruction is packed at a time, so
+/// a compressing or encoding `writer` turns a circuit into a payload in bounded memory.
+pub(crate) fn encode_qpy<'a, W: Write, I: Iterator<Item = CircuitInstruction<'a>>>(
+    writer: W,
+    num_qubits: u32,
+    num_clbits: u32,
+    instructions: impl Fn() -> I,
+) -> BinResult<W> {
+    let mut num_instructions = 0;
+    for inst in instructions() {
+        rewrite_instruction(&inst, |_, _, _, _| num_instructions += 1);
+    }
+    write_qpy(writer, num_qubits, num_clbits, num_instructions, |writer| {
+        // Each instruction is packed into `scratch` and handed to `writer` whole, rather than
+        // field by field.
+        let mut scratch = Cursor::new(Vec::new());
+        let mut result = Ok(());
+        for inst in instructions() {
+            rewrite_instruction(&inst, |name, qubits, clbits, params| {
+                if result.is_err() {
+                    return;
+                }
+                scratch.get_mut().clear();
+                scratch.set_position(0);
+                result = pack_instruction(name, qubits, clbits, params)
+                    .write(&mut scratch)
+                    .and_then(|()| Ok(writer.write_all(scratch.get_ref())?));
+            });
+        }
+        result
+    })
+}
+
+/// Write a circuit with the given instructions as QPY, without rewriting any of them.
+pub(crate) fn encode_qpy_verbatim<'a>(
+    num_qubits: u32,
+    num_clbits: u32,
+    circuit_instructions: impl ExactSizeIterator<Item = CircuitInstruction<'a>>,
+) -> BinResult<Vec<u8>> {
+    let num_instructions = circuit_instructions.len() as u64;
+    write_qpy(
+        Vec::new(),
+        num_qubits,
+        num_clbits,
+        num_instructions,
+        |writer| {
+            for inst in circuit_instructions {
+                pack_instruction(&inst.name, inst.qubits, inst.clbits, inst.params)
+                    .write(writer)?;
+            }
+            Ok(())
+        },
+    )
+}
+
+/// Write a QPY file holding one circuit, whose `num_instructions` instructions
+/// `write_instructions` writes between the circuit header and the trailer.
+fn write_qpy<W: Write>(
+    writer: W,
+    num_qubits: u32,
+    num_clbits: u32,
+    num_instructions: u64,
+    write_instructions: impl FnOnce(&mut NoSeek<W>) -> BinResult<()>,
+) -> BinResult<W> {
+    let mut writer = NoSeek::new(writer);
     qpy_formats::FileHeaderV14 {
         label: *b"QISKIT",
         qpy_version: 14,
@@ -41,15 +243,15 @@ pub fn generate_qpy_payload(circuit: &qiskit_circuit::Circuit) -> BinResult<Vec<
     .write(&mut writer)?;
     qpy_formats::ProgramType { type_key: b'q' }.write(&mut writer)?;
     let empty_json = "{}";
-    let circuit_header = qpy_formats::CircuitHeaderV12Pack {
+    qpy_formats::CircuitHeaderV12Pack {
         name_size: 0,
         global_phase_type: b'f',
         global_phase_size: 8,
-        num_qubits: circuit.num_qubits(),
-        num_clbits: circuit.num_clbits(),
+        num_qubits,
+        num_clbits,
         metadata_size: empty_json.len() as u64,
         num_registers: 1,
-        num_instructions: circuit.num_instructions() as u64,
+        num_instructions,
         num_vars: 0,
         circuit_name: Vec::new(),
         global_phase_data: 0_f64.to_be_bytes().to_vec(),
@@ -57,97 +259,312 @@ pub fn generate_qpy_payload(circuit: &qiskit_circuit::Circuit) -> BinResult<Vec<
         registers: vec![qpy_formats::RegisterV4Pack {
             register_type: b'c',
             standalone: true as u8,
-            size: circuit.num_clbits(),
+            size: num_clbits,
             name_size: 4,
             in_circuit: true as u8,
             name: "meas".as_bytes().to_vec(),
-            bit_indices: (0..circuit.num_clbits()).map(|x| x as i64).collect(),
+            bit_indices: (0..num_clbits).map(|x| x as i64).collect(),
         }],
-    };
-    let instructions =
-        circuit
-            .get_circuit_instructions()
-            .map(|inst| {
-                let out_name = match inst.name.as_str() {
-                    "x" => "XGate",
-                    "sx" => "SXGate",
-                    "cz" => "CZGate",
-                    "measure" => "Measure",
-                    "reset" => "Reset",
-                    "ecr" => "ECRGate",
-                    "cx" => "CXGate",
-                    "rz" => "RZGate",
-                    "id" => "IGate",
-                    "rx" => "RXGate",
-                    _ => panic!("Not an ISA circuit {}", inst.name),
-                };
-                let num_ctrl_qubits = if inst.name.as_str() == "cx" || inst.name.as_str() == "cz" {
-                    1
-                } else {
-                    0
-                };
-                let bit_data: Vec<qpy_formats::CircuitInstructionArgPack> =
-                    inst.qubits
-                        .iter()
-                        .map(|index| qpy_formats::CircuitInstructionArgPack {
-                            bit_type: b'q',
-                            index: *index,
-                        })
-                        .chain(inst.clbits.iter().map(|index| {
-                            qpy_formats::CircuitInstructionArgPack {
-                                bit_type: b'c',
-                                index: *index,
-                            }
-                        }))
-                        .collect();
-                let params: Vec<qpy_formats::PackedParam> = inst
-                    .params
-                    .iter()
-                    .map(|param| qpy_formats::PackedParam {
-                        type_key: b'f',
-                        data_len: 8,
-                        data: param.to_le_bytes().to_vec(),
-                    })
-                    .collect();
-                qpy_formats::CircuitInstructionV2Pack {
-                    name_size: out_name.len() as u16,
-                    label_size: 0,
-                    num_parameters: inst.params.len() as u16,
-                    num_qargs: inst.qubits.len() as u32,
-                    num_cargs: inst.clbits.len() as u32,
-                    conditional_key: 0,
-                    condition_register_size: 0,
-                    condition_value: 0,
-                    num_ctrl_qubits,
-                    ctrl_state: 1,
-                    gate_class_name: out_name.as_bytes().to_vec(),
-                    label_raw: Vec::new(),
-                    condition_raw: Vec::new(),
-                    bit_data,
-                    params,
+    }
+    .write(&mut writer)?;
+    qpy_formats::CustomCircuitInstructionsPack {
+        custom_operations_length: 0,
+        custom_instructions: Vec::new(),
+    }
+    .write(&mut writer)?;
+    write_instructions(&mut writer)?;
+    // No calibrations
+    0_u16.write_be(&mut writer)?;
+    qpy_formats::LayoutV2Pack {
+        exists: 0,
+        initial_layout_size: -1,
+        input_mapping_size: -1,
+        final_layout_size: -1,
+        extra_registers_length: 0,
+        input_qubit_count: 0,
+        extra_registers_data: Vec::new(),
+        array_data: Vec::new(),
+    }
+    .write(&mut writer)?;
+    Ok(writer.into_inner())
+}
+
+/// An instruction read back by [decode_qpy].
+#[derive(Debug, PartialEq)]
+pub(crate) struct DecodedInstruction {
+    pub name: &'static str,
+    pub qubits: Vec<u32>,
+    pub clbits: Vec<u32>,
+    pub params: Vec<f64>,
+}
+
+/// A circuit read back by [decode_qpy].
+#[derive(Debug, PartialEq)]
+pub(crate) struct DecodedCircuit {
+    pub num_qubits: u32,
+    pub num_clbits: u32,
+    pub instructions: Vec<DecodedInstruction>,
+}
+
+/// Reads big-endian fields, failing rather than reading past the end.
+struct Reader<'a>(&'a [u8]);
+
+impl Reader<'_> {
+    fn take(&mut self, n: usize) -> Option<&[u8]> {
+        if n > self.0.len() {
+            return None;
+        }
+        let (head, rest) = self.0.split_at(n);
+        self.0 = rest;
+        Some(head)
+    }
+
+    fn uint(&mut self, n: usize) -> Option<u64> {
+        Some(
+            self.take(n)?
+                .iter()
+                .fold(0, |acc, &byte| (acc << 8) | byte as u64),
+        )
+    }
+}
+
+/// Read back a payload written by [encode_qpy] or [encode_qpy_verbatim], returning `None` for
+/// anything else, such as QPY files with custom instructions or symbolic parameters.
+pub(crate) fn decode_qpy(payload: &[u8]) -> Option<DecodedCircuit> {
+    let mut reader = Reader(payload);
+    if reader.take(6)? != b"QISKIT" {
+        return None;
+    }
+    reader.take(4)?;
+    let num_circuits = reader.uint(8)?;
+    reader.take(1)?;
+    if num_circuits != 1 || reader.uint(1)? != b'q' as u64 {
+        return None;
+    }
+    let (name_size, _, phase_size) = (reader.uint(2)?, reader.uint(1)?, reader.uint(2)?);
+    let (num_qubits, num_clbits) = (reader.uint(4)? as u32, reader.uint(4)? as u32);
+    let metadata_size = reader.uint(8)?;
+    let (num_registers, num_instructions) = (reader.uint(4)?, reader.uint(8)?);
+    if reader.uint(4)? != 0 {
+        return None;
+    }
+    reader.take((name_size + phase_size + metadata_size) as usize)?;
+    for _ in 0..num_registers {
+        reader.take(2)?;
+        let size = reader.uint(4)?;
+        let name_size = reader.uint(2)?;
+        reader.take(1 + name_size as usize + 8 * size as usize)?;
+    }
+    if reader.uint(8)? != 0 {
+        return None;
+    }
+    let mut instructions = Vec::with_capacity(num_instructions.min(1 << 20) as usize);
+    for _ in 0..num_instructions {
+        let (name_size, label_size) = (reader.uint(2)?, reader.uint(2)?);
+        let num_params = reader.uint(2)?;
+        let (num_qargs, num_cargs) = (reader.uint(4)?, reader.uint(4)?);
+        reader.take(1)?;
+        let condition_size = reader.uint(2)?;
+        reader.take(8 + 4 + 4)?;
+        let class = reader.take(name_size as usize)?;
+        let (name, _) = GATE_CLASSES
+            .iter()
+            .find(|(_, name)| name.as_bytes() == class)?;
+        reader.take((label_size + condition_size) as usize)?;
+        let mut qubits = Vec::with_capacity(num_qargs as usize);
+        let mut clbits = Vec::with_capacity(num_cargs as usize);
+        for _ in 0..num_qargs + num_cargs {
+            let bits = match reader.uint(1)? as u8 {
+                b'q' => &mut qubits,
+                b'c' => &mut clbits,
+                _ => return None,
+            };
+            bits.push(reader.uint(4)? as u32);
+        }
+        let params = (0..num_params)
+            .map(|_| {
+                if reader.uint(1)? != b'f' as u64 || reader.uint(8)? != 8 {
+                    return None;
                 }
+                Some(f64::from_bits(reader.uint(8)?))
             })
-            .collect();
-
-    qpy_formats::QPYFormatV13 {
-        header: circuit_header,
-        custom_instructions: qpy_formats::CustomCircuitInstructionsPack {
-            custom_operations_length: 0,
-            custom_instructions: Vec::new(),
-        },
+            .collect::<Option<Vec<f64>>>()?;
+        instructions.push(DecodedInstruction {
+            name,
+            qubits,
+            clbits,
+            params,
+        });
+    }
+    // No calibrations and no layout, which end the payload.
+    if reader.uint(2)? != 0 || reader.uint(1)? != 0 {
+        return None;
+    }
+    reader.take(20)?;
+    if !reader.0.is_empty() {
+        return None;
+    }
+    Some(DecodedCircuit {
+        num_qubits,
+        num_clbits,
         instructions,
-        calibration_header: 0_u16.to_be_bytes().to_vec(),
-        layout: qpy_formats::LayoutV2Pack {
-            exists: 0,
-            initial_layout_size: -1,
-            input_mapping_size: -1,
-            final_layout_size: -1,
-            extra_registers_length: 0,
-            input_qubit_count: 0,
-            extra_registers_data: Vec::new(),
-            array_data: Vec::new(),
-        },
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn inst<'a>(name: &str, qubits: &'a [u32], params: &'a [f64]) -> CircuitInstruction<'a> {
+        CircuitInstruction {
+            name: name.to_string(),
+            qubits,
+            clbits: &[],
+            params,
+        }
+    }
+
+    #[derive(Debug, PartialEq)]
+    struct Decoded {
+        name: String,
+        qubits: Vec<u32>,
+        params: Vec<f64>,
+    }
+
+    fn decode(payload: &[u8]) -> Vec<Decoded> {
+        let circuit = decode_qpy(payload).unwrap();
+        assert_eq!(circuit.num_clbits, 0);
+        circuit
+            .instructions
+            .into_iter()
+            .map(|inst| Decoded {
+                name: inst.name.to_string(),
+                qubits: inst.qubits,
+                params: inst.params,
+            })
+            .collect()
+    }
+
+    fn decoded(name: &str, qubits: &[u32], params: &[f64]) -> Decoded {
+        Decoded {
+            name: name.to_string(),
+            qubits: qubits.to_vec(),
+            params: params.to_vec(),
+        }
+    }
+
+    #[test]
+    fn fractional_gates_round_trip() {
+        let qubits = [3, 5];
+        let instructions = vec![
+            inst("rzz", &qubits, &[0.25]),
+            inst("rzz", &qubits, &[-0.25]),
+            inst("rzz", &qubits, &[3. * PI / 4.]),
+            inst("rzz", &qubits, &[TAU]),
+            inst("rx", &qubits[..1], &[0.5]),
+            inst("rx", &qubits[..1], &[0.5 - TAU]),
+            inst("cz", &qubits, &[]),
+        ];
+        let payload = encode_qpy(Vec::new(), 6, 0, || instructions.clone().into_iter()).unwrap();
+        let expected = vec![
+            decoded("rzz", &[3, 5], &[0.25]),
+            decoded("x", &[3], &[]),
+            decoded("rzz", &[3, 5], &[0.25]),
+            decoded("x", &[3], &[]),
+            decoded("rz", &[3], &[PI]),
+            decoded("rz", &[5], &[PI]),
+            decoded("x", &[3], &[]),
+            decoded("rzz", &[3, 5], &[PI / 4.]),
+            decoded("x", &[3], &[]),
+            decoded("rx", &[3], &[0.5]),
+            decoded("rx", &[3], &[wrap_angle(0.5 - TAU)]),
+            decoded("cz", &[3, 5], &[]),
+        ];
+        assert_eq!(decode(&payload), expected);
+        assert!((wrap_angle(0.5 - TAU) - 0.5).abs() < 1e-12);
+    }
+
+    #[test]
+    fn verbatim_round_trip() {
+        let (qubits, params) = ([0, 2], [-2.5]);
+        let measure = CircuitInstruction {
+            name: "measure".to_string(),
+            qubits: &qubits[1..],
+            clbits: &[1],
+            params: &[],
+        };
+        let instructions = vec![
+            inst("rzz", &qubits, &params),
+            inst("barrier", &[0, 1, 2], &[]),
+            inst("reset", &[1], &[]),
+            measure,
+        ];
+        let payload = encode_qpy_verbatim(3, 2, instructions.into_iter()).unwrap();
+        let circuit = decode_qpy(&payload).unwrap();
+        assert_eq!((circuit.num_qubits, circuit.num_clbits), (3, 2));
+        let bits =
+            |inst: &DecodedInstruction| (inst.name, inst.qubits.clone(), inst.clbits.clone());
+        assert_eq!(
+            circuit.instructions.iter().map(bits).collect::<Vec<_>>(),
+            [
+                ("rzz", vec![0, 2], vec![]),
+                ("barrier", vec![0, 1, 2], vec![]),
+                ("reset", vec![1], vec![]),
+                ("measure", vec![2], vec![1]),
+            ]
+        );
+        assert_eq!(circuit.instructions[0].params, [-2.5]);
+        for end in 0..payload.len() {
+            assert_eq!(decode_qpy(&payload[..end]), None);
+        }
+    }
+
+    /// Apply `gates` to the two-qubit basis state `state` (bit 0 is the first qubit), which
+    /// these gates map to a basis state times a phase.
+    fn apply(gates: &[(String, Vec<u32>, Vec<f64>)], state: usize) -> (usize, f64) {
+        let mut state = state;
+        let mut phase = 0.;
+        let bit = |state: usize, qubit: u32| if state >> qubit & 1 == 1 { 1. } else { -1. };
+        for (name, qubits, params) in gates {
+            match name.as_str() {
+                "x" => state ^= 1 << qubits[0],
+                "rz" => phase += params[0] / 2. * bit(state, qubits[0]),
+                "rzz" => phase -= params[0] / 2. * bit(state, 0) * bit(state, 1),
+                _ => unreachable!(),
+            }
+        }
+        (state, phase)
+    }
+
+    #[test]
+    fn folded_rzz_matches_up_to_global_phase() {
+        for step in -40..=40 {
+            let angle = step as f64 * PI / 16.;
+            let mut folded = Vec::new();
+            fold_rzz(angle, &[0, 1], |name, qubits, params| {
+                folded.push((name.to_string(), qubits.to_vec(), params.to_vec()))
+            });
+            for (_, _, params) in folded.iter().filter(|(name, _, _)| name == "rzz") {
+                assert!((0. ..=FRAC_PI_2).contains(&params[0]), "{}", angle);
+            }
+            let original = [("rzz".to_string(), vec![0, 1], vec![angle])];
+            let phases: Vec<f64> = (0..4)
+                .map(|state| {
+                    let (expected_state, expected) = apply(&original, state);
+                    let (folded_state, phase) = apply(&folded, state);
+                    assert_eq!(folded_state, expected_state);
+                    phase - expected
+                })
+                .collect();
+            for phase in &phases[1..] {
+                let difference = wrap_angle(phase - phases[0]);
+                assert!(
+                    difference.abs() < 1e-9,
+                    "{} differs by {}",
+                    angle,
+                    difference
+                );
+            }
+        }
     }
-    .write(&mut writer)?;
-    Ok(writer.into_inner())
 }
@@ -0,0 +1,173 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Checking that a circuit only uses instructions a backend supports, on qubits it supports
+//! them on, before it is encoded and submitted.
+
+use std::fmt::{Display, Formatter};
+
+use crate::backend_data::TargetData;
+use crate::fidelity::Operation;
+use crate::qiskit_circuit::CircuitInstruction;
+
+/// Why an instruction can't run on a backend as is.
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[repr(u32)]
+pub enum IsaViolationKind {
+    /// The backend has no such instruction.
+    UnsupportedOperation = 0,
+    /// A qubit is beyond the backend's qubits.
+    QubitOutOfRange = 1,
+    /// The backend doesn't support the instruction on these qubits, e.g. a two-qubit gate
+    /// between uncoupled qubits or against the coupler's direction.
+    UnsupportedQubits = 2,
+}
+
+#[repr(C)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+pub struct IsaViolation {
+    /// The index of the instruction in the circuit.
+    pub instruction: usize,
+    pub kind: IsaViolationKind,
+}
+
+/// The violations found in a circuit, in instruction order.
+#[derive(Debug, Default)]
+pub struct IsaReport {
+    pub violations: Vec<IsaViolation>,
+}
+
+impl IsaReport {
+    pub fn is_valid(&self) -> bool {
+        self.violations.is_empty()
+    }
+}
+
+impl Display for IsaReport {
+    fn fmt(&self, f: &mut Formatter<'_>) -> std::fmt::Result {
+        const SHOWN: usize = 5;
+        for (i, violation) in self.violations.iter().take(SHOWN).enumerate() {
+            if i > 0 {
+                write!(f, ", ")?;
+            }
+            write!(
+                f,
+                "instruction {}: {:?}",
+                violation.instruction, violation.kind
+            )?;
+        }
+        if self.violations.len() > SHOWN {
+            write!(f, " and {} more", self.violations.len() - SHOWN)?;
+        }
+        Ok(())
+    }
+}
+
+/// Check every instruction against the backend of `data` in one pass. Barriers only need their
+/// qubits to exist.
+pub(crate) fn validate_isa<'a>(
+    instructions: impl Iterator<Item = CircuitInstruction<'a>>,
+    data: &TargetData,
+) -> IsaReport {
+    let index = data.fidelity_index();
+    let violations = instructions
+        .enumerate()
+        .filter_map(|(instruction, inst)| {
+            let kind = if inst.qubits.iter().any(|&q| q >= data.num_qubits) {
+                IsaViolationKind::QubitOutOfRange
+            } else if inst.name == "barrier" {
+                return None;
+            } else {
+                match Operation::from_name(&inst.name) {
+                    None => IsaViolationKind::UnsupportedOperation,
+                    Some(operation) if !index.supports(operation, inst.qubits) => {
+                        IsaViolationKind::UnsupportedQubits
+                    }
+                    Some(_) => return None,
+                }
+            };
+            Some(IsaViolation { instruction, kind })
+        })
+        .collect();
+    IsaReport { violations }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::qiskit_target::ISAGate;
+
+    fn inst<'a>(name: &str, qubits: &'a [u32]) -> CircuitInstruction<'a> {
+        CircuitInstruction {
+            name: name.to_string(),
+            qubits,
+            clbits: &[],
+            params: &[],
+        }
+    }
+
+    #[test]
+    fn violations_are_reported_per_instruction() {
+        let data = TargetData {
+            num_qubits: 3,
+            gates: vec![
+                (
+                    ISAGate::SX,
+                    (0..3).map(|q| (vec![q], [None, Some(1e-4)])).collect(),
+                ),
+                (ISAGate::ECR, vec![(vec![0, 1], [None, Some(1e-2)])]),
+            ],
+            measure: (0..3).map(|q| (q, [None, Some(0.01)])).collect(),
+            ..Default::default()
+        };
+        let circuit = [
+            inst("sx", &[2]),
+            inst("ecr", &[0, 1]),
+            inst("barrier", &[0, 1, 2]),
+            inst("measure", &[0]),
+        ];
+        assert!(validate_isa(circuit.into_iter(), &data).is_valid());
+
+        let circuit = [
+            inst("sx", &[0]),
+            inst("h", &[0]),
+            inst("ecr", &[1, 0]),
+            inst("ecr", &[1, 2]),
+            inst("sx", &[3]),
+            inst("barrier", &[0, 5]),
+            inst("reset", &[0]),
+        ];
+        let report = validate_isa(circuit.into_iter(), &data);
+        let violations: Vec<_> = report
+            .violations
+            .iter()
+            .map(|x| (x.instruction, x.kind))
+            .collect();
+        assert_eq!(
+            violations,
+            [
+                (1, IsaViolationKind::UnsupportedOperation),
+                (2, IsaViolationKind::UnsupportedQubits),
+                (3, IsaViolationKind::UnsupportedQubits),
+                (4, IsaViolationKind::QubitOutOfRange),
+                (5, IsaViolationKind::QubitOutOfRange),
+                (6, IsaViolationKind::UnsupportedQubits),
+            ]
+        );
+        assert_eq!(
+            report.to_string(),
+            "instruction 1: UnsupportedOperation, instruction 2: UnsupportedQubits, \
+             instruction 3: UnsupportedQubits, instruction 4: QubitOutOfRange, \
+             instruction 5: QubitOutOfRange and 1 more"
+        );
+    }
+}
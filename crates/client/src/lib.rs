@@ -10,15 +10,25 @@
 // copyright notice, and modified files need to carry a notice indicating
 // that they have been altered from the originals.
 
+mod backend_data;
 mod c_api;
+mod cache;
+mod fidelity;
 mod generate_job_params;
 pub mod generate_qpy;
+mod isa;
+mod pipeline;
 mod pointers;
+mod predictor;
 pub mod qiskit_circuit;
 mod qiskit_ffi;
 pub mod qiskit_target;
 mod qpy_formats;
+mod qubit_subset;
 mod service;
+#[cfg(test)]
+mod test_server;
+mod transpile;
 
 pub use c_api::generate_qpy;
 
@@ -101,6 +111,15 @@ fn log_warn(e: &impl AsRef<str>) {
     }
 }
 
+fn log_info(e: &impl AsRef<str>) {
+    match std::env::var("QISKIT_IBM_RUNTIME_LOG_LEVEL") {
+        Ok(level) if matches!(level.to_uppercase().as_str(), "INFO" | "DEBUG") => {
+            eprintln!("* INFO: {}", e.as_ref())
+        }
+        _ => (),
+    }
+}
+
 fn log_debug(e: &impl AsRef<str>) {
     match std::env::var("QISKIT_IBM_RUNTIME_LOG_LEVEL") {
         Ok(level) if matches!(level.to_uppercase().as_str(), "DEBUG") => {
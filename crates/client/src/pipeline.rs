@@ -0,0 +1,514 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Moving circuits from transpilation to submission on pools of worker threads.
+//!
+//! Each stage of a [Pipeline] has its own threads. They take circuits from a bounded queue and
+//! pass them on to the queue of the next stage. A full queue blocks the stage feeding it, so a
+//! slow stage, typically submission, holds back the stages before it instead of letting
+//! transpiled circuits pile up in memory.
+
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::mpsc::{sync_channel, Receiver, SyncSender};
+use std::sync::{Arc, Mutex};
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+
+use crate::backend_data::TargetData;
+use crate::isa::validate_isa;
+use crate::qiskit_circuit::Circuit;
+use crate::qiskit_ffi::{self, QkTranspileOptions};
+use crate::qiskit_target::Target;
+use crate::service::{
+    encode_sampler_job, submit_encoded_job, Backend, EncodedJob, Job, Service, ServiceError,
+};
+use crate::ExitCode;
+
+/// How many threads encode jobs unless told otherwise.
+const DEFAULT_ENCODE_WORKERS: usize = 2;
+/// How many jobs are submitted at once unless told otherwise.
+const DEFAULT_SUBMIT_WORKERS: usize = 4;
+/// How many circuits wait for each stage before the stage feeding it blocks, unless told
+/// otherwise.
+const DEFAULT_QUEUE_CAPACITY: usize = 16;
+
+/// The stages of a [Pipeline], in the order circuits go through them.
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[repr(u32)]
+pub enum PipelineStage {
+    /// Fetching the backend's target, once when the pipeline starts.
+    Target = 0,
+    Transpile = 1,
+    IsaCheck = 2,
+    /// Encoding the circuit as compressed QPY in a job request.
+    Encode = 3,
+    Submit = 4,
+}
+
+pub(crate) const NUM_STAGES: usize = 5;
+
+#[repr(C)]
+#[derive(Copy, Clone, Debug)]
+pub struct PipelineOptions {
+    /// Threads transpiling circuits, or 0 for one per core.
+    pub transpile_workers: u32,
+    /// Threads encoding jobs, or 0 for [DEFAULT_ENCODE_WORKERS].
+    pub encode_workers: u32,
+    /// Jobs submitted at once, or 0 for [DEFAULT_SUBMIT_WORKERS].
+    pub submit_workers: u32,
+    /// Circuits waiting for each stage before the stage feeding it blocks, or 0 for
+    /// [DEFAULT_QUEUE_CAPACITY].
+    pub queue_capacity: u32,
+    /// Shots of each job, or 0 for the sampler's default.
+    pub shots: i32,
+    pub transpile: QkTranspileOptions,
+}
+
+/// The counters of one stage, updated by its workers.
+#[derive(Debug, Default)]
+struct StageCounters {
+    queued: AtomicUsize,
+    max_queued: AtomicUsize,
+    processed: AtomicU64,
+    failed: AtomicU64,
+    busy_nanos: AtomicU64,
+}
+
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default, PartialEq)]
+pub struct PipelineStageStats {
+    /// Circuits the stage passed on.
+    pub processed: u64,
+    /// Circuits that failed in the stage.
+    pub failed: u64,
+    /// Circuits waiting for the stage.
+    pub queue_depth: usize,
+    /// The most circuits that waited for the stage at once.
+    pub max_queue_depth: usize,
+    /// Time the stage's workers spent working, summed over the workers.
+    pub busy_seconds: f64,
+    /// Circuits processed per second since the pipeline started.
+    pub throughput: f64,
+}
+
+impl StageCounters {
+    fn stats(&self, elapsed: Duration) -> PipelineStageStats {
+        let processed = self.processed.load(Ordering::Relaxed);
+        PipelineStageStats {
+            processed,
+            failed: self.failed.load(Ordering::Relaxed),
+            queue_depth: self.queued.load(Ordering::Relaxed),
+            max_queue_depth: self.max_queued.load(Ordering::Relaxed),
+            busy_seconds: self.busy_nanos.load(Ordering::Relaxed) as f64 * 1e-9,
+            throughput: processed as f64 / elapsed.as_secs_f64().max(1e-9),
+        }
+    }
+}
+
+type Item<T> = (usize, T);
+
+/// The sending end of a stage's queue.
+struct QueueSender<T> {
+    sender: SyncSender<Item<T>>,
+    counters: Arc<StageCounters>,
+}
+
+impl<T> QueueSender<T> {
+    /// Queue `item`, blocking while the queue is full. A blocked item counts as waiting.
+    fn send(&self, index: usize, item: T) {
+        let queued = self.counters.queued.fetch_add(1, Ordering::Relaxed) + 1;
+        self.counters
+            .max_queued
+            .fetch_max(queued, Ordering::Relaxed);
+        // This only fails if every worker of the stage is gone, which only a panic does.
+        let _ = self.sender.send((index, item));
+    }
+}
+
+/// The receiving end of a stage's queue, shared by the stage's workers.
+struct QueueReceiver<T> {
+    receiver: Mutex<Receiver<Item<T>>>,
+    counters: Arc<StageCounters>,
+}
+
+impl<T> QueueReceiver<T> {
+    /// The next item, or `None` once the queue is empty and every sender is gone.
+    fn recv(&self) -> Option<Item<T>> {
+        let item = self.receiver.lock().unwrap().recv().ok()?;
+        self.counters.queued.fetch_sub(1, Ordering::Relaxed);
+        Some(item)
+    }
+}
+
+fn queue<T>(
+    capacity: usize,
+    counters: &Arc<StageCounters>,
+) -> (QueueSender<T>, Arc<QueueReceiver<T>>) {
+    let (sender, receiver) = sync_channel(capacity);
+    let counters = counters.clone();
+    (
+        QueueSender {
+            sender,
+            counters: counters.clone(),
+        },
+        Arc::new(QueueReceiver {
+            receiver: Mutex::new(receiver),
+            counters,
+        }),
+    )
+}
+
+/// The outcome of each circuit, in the order they were queued, once known.
+type Outcomes<R> = Arc<Mutex<Vec<Option<Result<R, ServiceError>>>>>;
+
+/// Start `workers` threads taking items from `input`. Each thread sets up its own state with
+/// `init`, runs `work` on every item it takes and hands the output to `emit`, or records why
+/// the item failed in `outcomes`.
+fn spawn_stage<S, I, O, R>(
+    threads: &mut Vec<JoinHandle<()>>,
+    workers: usize,
+    input: Arc<QueueReceiver<I>>,
+    outcomes: &Outcomes<R>,
+    init: impl Fn() -> S + Send + Sync + 'static,
+    work: impl Fn(&mut S, I) -> Result<O, ServiceError> + Send + Sync + 'static,
+    emit: impl Fn(usize, O) + Send + Sync + 'static,
+) where
+    I: Send + 'static,
+    R: Send + 'static,
+{
+    let stage = Arc::new((init, work, emit));
+    for _ in 0..workers {
+        let (stage, input, outcomes) = (stage.clone(), input.clone(), outcomes.clone());
+        threads.push(std::thread::spawn(move || {
+            let (init, work, emit) = &*stage;
+            let mut state = init();
+            while let Some((index, item)) = input.recv() {
+                let start = Instant::now();
+                let result = work(&mut state, item);
+                // Time blocked on the next stage's queue isn't work.
+                input
+                    .counters
+                    .busy_nanos
+                    .fetch_add(start.elapsed().as_nanos() as u64, Ordering::Relaxed);
+                match result {
+                    Ok(output) => {
+                        input.counters.processed.fetch_add(1, Ordering::Relaxed);
+                        emit(index, output);
+                    }
+                    Err(e) => {
+                        input.counters.failed.fetch_add(1, Ordering::Relaxed);
+                        outcomes.lock().unwrap()[index] = Some(Err(e));
+                    }
+                }
+            }
+        }));
+    }
+}
+
+/// A circuit owned by the pipeline, freed on drop.
+struct OwnedCircuit(Circuit);
+
+// The circuit is exclusively owned by this handle, so moving it to another thread is sound.
+unsafe impl Send for OwnedCircuit {}
+
+impl Drop for OwnedCircuit {
+    fn drop(&mut self) {
+        unsafe { qiskit_ffi::qk_circuit_free(self.0 .0) };
+    }
+}
+
+/// Circuits on their way from transpilation to submission as sampler jobs on one backend, see
+/// the module documentation.
+pub struct Pipeline {
+    input: Option<QueueSender<OwnedCircuit>>,
+    started: Instant,
+    finished: Option<Instant>,
+    stages: [Arc<StageCounters>; NUM_STAGES],
+    outcomes: Outcomes<Job>,
+    threads: Vec<JoinHandle<()>>,
+}
+
+impl Pipeline {
+    /// Start the workers of every stage, for circuits transpiled against `target`, which was
+    /// built from `data` in `target_time`.
+    pub(crate) fn start(
+        service: &Service,
+        backend: &Backend,
+        target: Target,
+        data: Arc<TargetData>,
+        target_time: Duration,
+        options: &PipelineOptions,
+    ) -> Self {
+        let or_default = |workers: u32, default: usize| match workers {
+            0 => default,
+            n => n as usize,
+        };
+        let transpile_workers = or_default(
+            options.transpile_workers,
+            std::thread::available_parallelism().map_or(1, |n| n.get()),
+        );
+        let encode_workers = or_default(options.encode_workers, DEFAULT_ENCODE_WORKERS);
+        let submit_workers = or_default(options.submit_workers, DEFAULT_SUBMIT_WORKERS);
+        let capacity = or_default(options.queue_capacity, DEFAULT_QUEUE_CAPACITY);
+
+        let stages: [Arc<StageCounters>; NUM_STAGES] = Default::default();
+        let fetch = &stages[PipelineStage::Target as usize];
+        fetch.processed.store(1, Ordering::Relaxed);
+        fetch
+            .busy_nanos
+            .store(target_time.as_nanos() as u64, Ordering::Relaxed);
+        let outcomes = Outcomes::default();
+        let mut threads = Vec::new();
+        let (input, transpile_queue) = queue(capacity, &stages[PipelineStage::Transpile as usize]);
+        let (to_check, check_queue) = queue(capacity, &stages[PipelineStage::IsaCheck as usize]);
+        let (to_encode, encode_queue) = queue(capacity, &stages[PipelineStage::Encode as usize]);
+        let (to_submit, submit_queue) = queue(capacity, &stages[PipelineStage::Submit as usize]);
+
+        let targets = Mutex::new(
+            (0..transpile_workers)
+                .map(|_| target.copy())
+                .collect::<Vec<_>>(),
+        );
+        let transpile_options = options.transpile;
+        spawn_stage(
+            &mut threads,
+            transpile_workers,
+            transpile_queue,
+            &outcomes,
+            move || targets.lock().unwrap().pop().unwrap(),
+            move |target, circuit: OwnedCircuit| {
+                crate::transpile::transpile(circuit.0 .0, target, &transpile_options)
+                    .map(|transpiled| OwnedCircuit(transpiled.into_circuit()))
+                    .map_err(|(_, message)| ServiceError {
+                        code: ExitCode::BadArgumentError,
+                        message,
+                    })
+            },
+            move |index, circuit| to_check.send(index, circuit),
+        );
+
+        let name = backend.name.to_string_lossy().into_owned();
+        spawn_stage(
+            &mut threads,
+            1,
+            check_queue,
+            &outcomes,
+            || (),
+            move |_, circuit: OwnedCircuit| {
+                let report = validate_isa(circuit.0.get_circuit_instructions(), &data);
+                if report.is_valid() {
+                    return Ok(circuit);
+                }
+                Err(ServiceError {
+                    code: ExitCode::BadArgumentError,
+                    message: format!("Not an ISA circuit for {}: {}", name, report),
+                })
+            },
+            move |index, circuit| to_encode.send(index, circuit),
+        );
+
+        let shots = (options.shots > 0).then_some(options.shots);
+        let encode_backend = backend.clone();
+        spawn_stage(
+            &mut threads,
+            encode_workers,
+            encode_queue,
+            &outcomes,
+            || (),
+            move |_, circuit: OwnedCircuit| {
+                Ok(encode_sampler_job(
+                    &encode_backend,
+                    &circuit.0,
+                    shots,
+                    None,
+                    None,
+                ))
+            },
+            move |index, job| to_submit.send(index, job),
+        );
+
+        let (service, backend) = (service.clone(), backend.clone());
+        let submitted = outcomes.clone();
+        spawn_stage(
+            &mut threads,
+            submit_workers,
+            submit_queue,
+            &outcomes,
+            || {
+                tokio::runtime::Builder::new_current_thread()
+                    .enable_all()
+                    .build()
+                    .unwrap()
+            },
+            move |rt, job: EncodedJob| rt.block_on(submit_encoded_job(&service, &backend, job)),
+            move |index, job| submitted.lock().unwrap()[index] = Some(Ok(job)),
+        );
+
+        Pipeline {
+            input: Some(input),
+            started: Instant::now() - target_time,
+            finished: None,
+            stages,
+            outcomes,
+            threads,
+        }
+    }
+
+    /// Queue `circuit`, which the pipeline takes ownership of, waiting while the transpile
+    /// queue is full. Returns the circuit's index among the outcomes of [Pipeline::finish].
+    ///
+    /// If the pipeline is already finished, the circuit is left to the caller.
+    pub fn submit(&mut self, circuit: Circuit) -> Result<usize, ServiceError> {
+        let Some(input) = &self.input else {
+            return Err(ServiceError {
+                code: ExitCode::BadArgumentError,
+                message: "The pipeline is already finished".to_string(),
+            });
+        };
+        let circuit = OwnedCircuit(circuit);
+        let index = {
+            let mut outcomes = self.outcomes.lock().unwrap();
+            outcomes.push(None);
+            outcomes.len() - 1
+        };
+        input.send(index, circuit);
+        Ok(index)
+    }
+
+    /// The number of circuits queued so far.
+    pub fn num_queued(&self) -> usize {
+        self.outcomes.lock().unwrap().len()
+    }
+
+    /// Wait for every queued circuit to be submitted or to fail, and return the outcomes in
+    /// the order the circuits were queued. No circuits can be queued afterwards.
+    pub fn finish(&mut self) -> Vec<Result<Job, ServiceError>> {
+        self.input = None;
+        for thread in self.threads.drain(..) {
+            let _ = thread.join();
+        }
+        self.finished.get_or_insert_with(Instant::now);
+        self.outcomes
+            .lock()
+            .unwrap()
+            .iter_mut()
+            .map(|outcome| {
+                outcome.take().unwrap_or_else(|| {
+                    Err(ServiceError {
+                        code: ExitCode::QuantumAPIUnhandledError,
+                        message: "A pipeline worker failed unexpectedly".to_string(),
+                    })
+                })
+            })
+            .collect()
+    }
+
+    /// The progress of each stage, indexed by [PipelineStage].
+    pub fn stats(&self) -> [PipelineStageStats; NUM_STAGES] {
+        let elapsed = self.finished.unwrap_or_else(Instant::now) - self.started;
+        std::array::from_fn(|stage| self.stages[stage].stats(elapsed))
+    }
+}
+
+impl Drop for Pipeline {
+    fn drop(&mut self) {
+        self.input = None;
+        for thread in self.threads.drain(..) {
+            let _ = thread.join();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn stages_apply_backpressure_and_keep_order() {
+        let counters: [Arc<StageCounters>; 2] = Default::default();
+        let outcomes: Outcomes<u64> = Arc::new(Mutex::new(vec![None; 40]));
+        let mut threads = Vec::new();
+        let (input, first) = queue(2, &counters[0]);
+        let (to_second, second) = queue(2, &counters[1]);
+        spawn_stage(
+            &mut threads,
+            3,
+            first,
+            &outcomes,
+            || (),
+            |_, x: u64| match x % 10 {
+                7 => Err(ServiceError {
+                    code: ExitCode::BadArgumentError,
+                    message: format!("{} failed", x),
+                }),
+                _ => Ok(x * 2),
+            },
+            move |index, x| to_second.send(index, x),
+        );
+        let done = outcomes.clone();
+        spawn_stage(
+            &mut threads,
+            1,
+            second,
+            &outcomes,
+            || (),
+            |_, x: u64| {
+                std::thread::sleep(Duration::from_millis(2));
+                Ok(x + 1)
+            },
+            move |index, x| done.lock().unwrap()[index] = Some(Ok(x)),
+        );
+        for x in 0..40 {
+            input.send(x as usize, x);
+        }
+        drop(input);
+        for thread in threads {
+            thread.join().unwrap();
+        }
+
+        let outcomes = outcomes.lock().unwrap();
+        for (x, outcome) in outcomes.iter().enumerate() {
+            match outcome.as_ref().unwrap() {
+                Ok(y) => assert_eq!(*y, 2 * x as u64 + 1),
+                Err(e) => assert_eq!(e.message(), format!("{} failed", x)),
+            }
+        }
+        let elapsed = Duration::from_secs(1);
+        let (first, second) = (counters[0].stats(elapsed), counters[1].stats(elapsed));
+        assert_eq!((first.processed, first.failed), (36, 4));
+        assert_eq!((second.processed, second.failed), (36, 0));
+        assert_eq!((first.queue_depth, second.queue_depth), (0, 0));
+        // The slow second stage fills its queue, which blocks the first stage's three workers
+        // and in turn fills the first queue. Neither holds more than its capacity, plus the
+        // senders blocked on it and the items being handed to its workers.
+        assert!((2..=2 + 3 + 1).contains(&second.max_queue_depth));
+        assert!((2..=2 + 1 + 3).contains(&first.max_queue_depth));
+        assert!(second.busy_seconds >= 36. * 0.002);
+    }
+
+    #[test]
+    fn submit_after_finish_leaves_the_circuit_to_the_caller() {
+        let mut pipeline = Pipeline {
+            input: None,
+            started: Instant::now(),
+            finished: None,
+            stages: Default::default(),
+            outcomes: Default::default(),
+            threads: Vec::new(),
+        };
+        // Never dereferenced unless the pipeline wrongly takes ownership and frees it.
+        let circuit = Circuit(std::ptr::NonNull::dangling().as_ptr());
+        let error = pipeline.submit(circuit).unwrap_err();
+        assert!(matches!(error.code, ExitCode::BadArgumentError));
+        assert_eq!(pipeline.num_queued(), 0);
+    }
+}
@@ -0,0 +1,471 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Predicting how long a job takes from submission to result.
+//!
+//! A prediction is the queue wait plus the execution time. The queue wait is the backend's queue
+//! length times a learned wait per queued job. The execution time is a rough QPU-time estimate
+//! of the circuit, times a learned correction factor. Both learned quantities are running
+//! averages over the finished jobs observed through [Predictor::observe], and persist across
+//! processes.
+
+use chrono::{DateTime, Utc};
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet};
+use std::path::PathBuf;
+use std::sync::Mutex;
+use std::time::SystemTime;
+
+use ibm_quantum_platform_api::models::JobMetrics;
+
+use crate::backend_data::TargetData;
+use crate::cache::{cache_dir, read_json, write_json_atomic};
+use crate::fidelity::Operation;
+use crate::log_warn;
+use crate::qiskit_circuit::{Circuit, CircuitInstruction};
+
+/// Bump this whenever the layout of [PredictorFile] changes so stale files are ignored.
+const PREDICTOR_VERSION: u32 = 1;
+/// The wait each job ahead in the queue is assumed to add before any job has been observed.
+const DEFAULT_SECONDS_PER_QUEUED_JOB: f64 = 30.;
+/// Weight of a new observation in the running averages.
+const LEARNING_RATE: f64 = 0.2;
+/// The number of shots the sampler runs when the job doesn't specify it.
+pub(crate) const DEFAULT_SHOTS: i32 = 4096;
+/// Fixed per-job cost of loading and starting a job on the QPU.
+const JOB_OVERHEAD_SECONDS: f64 = 2.;
+/// Default delay between shots.
+pub(crate) const REP_DELAY_SECONDS: f64 = 250e-6;
+
+/// Typical instruction durations used when no target is at hand.
+fn typical_duration(name: &str, num_qubits: usize) -> f64 {
+    match name {
+        "measure" => 1.5e-6,
+        "reset" => 1e-6,
+        "rz" | "barrier" => 0.,
+        _ if num_qubits >= 2 => 100e-9,
+        _ => 50e-9,
+    }
+}
+
+/// Estimate the QPU seconds taken to run `shots` shots of `circuit`.
+///
+/// Each shot takes the circuit's critical path, with typical instruction durations, plus the
+/// delay between shots.
+pub(crate) fn estimate_qpu_seconds(circuit: &Circuit, shots: i32) -> f64 {
+    let shot_seconds = critical_path(
+        circuit.num_qubits(),
+        circuit.get_circuit_instructions(),
+        |inst| typical_duration(&inst.name, inst.qubits.len()),
+    ) + REP_DELAY_SECONDS;
+    JOB_OVERHEAD_SECONDS + shots as f64 * shot_seconds
+}
+
+/// The length of the schedule of `instructions` on `num_qubits` qubits, with each instruction
+/// starting once all its qubits are free and taking `duration`.
+fn critical_path<'a>(
+    num_qubits: u32,
+    instructions: impl Iterator<Item = CircuitInstruction<'a>>,
+    duration: impl Fn(&CircuitInstruction) -> f64,
+) -> f64 {
+    let mut ready = vec![0f64; num_qubits as usize];
+    for inst in instructions {
+        let start = inst
+            .qubits
+            .iter()
+            .map(|&q| ready.get(q as usize).copied().unwrap_or(0.))
+            .fold(0., f64::max);
+        let end = start + duration(&inst);
+        for &q in inst.qubits {
+            if let Some(ready) = ready.get_mut(q as usize) {
+                *ready = end;
+            }
+        }
+    }
+    ready.into_iter().fold(0., f64::max)
+}
+
+/// The QPU time of a job, estimated from the durations a backend reports.
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default, PartialEq)]
+pub struct QpuTimeEstimate {
+    /// The critical path of one shot.
+    pub schedule_seconds: f64,
+    /// The delay between shots.
+    pub rep_delay: f64,
+    /// The whole job, including the fixed cost of starting it.
+    pub total_seconds: f64,
+}
+
+/// Estimate the QPU time of `shots` shots of a circuit on the backend of `data`, with
+/// `rep_delay` seconds between shots.
+///
+/// Each instruction takes the duration the backend reports for it on its qubits, such as the
+/// gate length or readout length, or its typical duration if none is reported.
+pub(crate) fn estimate_qpu_time<'a>(
+    num_qubits: u32,
+    instructions: impl Iterator<Item = CircuitInstruction<'a>>,
+    data: &TargetData,
+    shots: i32,
+    rep_delay: f64,
+) -> QpuTimeEstimate {
+    let index = data.fidelity_index();
+    let schedule_seconds = critical_path(num_qubits, instructions, |inst| {
+        Operation::from_name(&inst.name)
+            .and_then(|operation| index.duration(operation, inst.qubits))
+            .filter(|duration| duration.is_finite())
+            .unwrap_or_else(|| typical_duration(&inst.name, inst.qubits.len()))
+    });
+    QpuTimeEstimate {
+        schedule_seconds,
+        rep_delay,
+        total_seconds: JOB_OVERHEAD_SECONDS + shots as f64 * (schedule_seconds + rep_delay),
+    }
+}
+
+/// Seconds from submission to result, split into waiting in the queue and running.
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default)]
+pub struct CompletionPrediction {
+    pub queue_wait: f64,
+    pub execution: f64,
+    pub total: f64,
+}
+
+impl CompletionPrediction {
+    fn new(queue_wait: f64, execution: f64) -> Self {
+        CompletionPrediction {
+            queue_wait,
+            execution,
+            total: queue_wait + execution,
+        }
+    }
+}
+
+/// What the predictor has learned about one backend.
+#[derive(Copy, Clone, Debug, Deserialize, Serialize)]
+struct BackendHistory {
+    seconds_per_queued_job: f64,
+    /// Observed QPU time over [estimate_qpu_seconds].
+    qpu_time_scale: f64,
+    wait_observations: u32,
+    qpu_observations: u32,
+}
+
+impl Default for BackendHistory {
+    fn default() -> Self {
+        BackendHistory {
+            seconds_per_queued_job: DEFAULT_SECONDS_PER_QUEUED_JOB,
+            qpu_time_scale: 1.,
+            wait_observations: 0,
+            qpu_observations: 0,
+        }
+    }
+}
+
+/// Fold `sample` into a running average. The first observation replaces the prior outright.
+fn update_average(average: &mut f64, observations: &mut u32, sample: f64) {
+    if !sample.is_finite() || sample < 0. {
+        return;
+    }
+    if *observations == 0 {
+        *average = sample;
+    } else {
+        *average += LEARNING_RATE * (sample - *average);
+    }
+    *observations += 1;
+}
+
+#[derive(Default, Deserialize, Serialize)]
+struct PredictorFile {
+    version: u32,
+    backends: HashMap<String, BackendHistory>,
+}
+
+/// What was known about a job when it was submitted, to compare with its metrics later.
+#[derive(Copy, Clone, Debug, Default)]
+pub(crate) struct SubmissionRecord {
+    pub queue_length: i32,
+    pub estimated_qpu_seconds: f64,
+}
+
+fn parse_time(time: Option<&String>) -> Option<DateTime<Utc>> {
+    DateTime::parse_from_rfc3339(time?)
+        .ok()
+        .map(|x| x.with_timezone(&Utc))
+}
+
+fn now() -> DateTime<Utc> {
+    SystemTime::now().into()
+}
+
+fn seconds_between(from: DateTime<Utc>, to: DateTime<Utc>) -> f64 {
+    (to - from).num_milliseconds() as f64 / 1000.
+}
+
+/// Per-backend queue and execution models, persisted in the cache directory.
+#[derive(Debug)]
+pub(crate) struct Predictor {
+    path: Option<PathBuf>,
+    backends: Mutex<HashMap<String, BackendHistory>>,
+    /// The jobs already learned from in this process, so each counts once.
+    learned: Mutex<HashSet<String>>,
+}
+
+impl Predictor {
+    pub fn load() -> Self {
+        let path = cache_dir().map(|dir| dir.join("predictor.json"));
+        let backends = path
+            .as_deref()
+            .and_then(read_json::<PredictorFile>)
+            .filter(|file| file.version == PREDICTOR_VERSION)
+            .map(|file| file.backends)
+            .unwrap_or_default();
+        Predictor {
+            path,
+            backends: Mutex::new(backends),
+            learned: Mutex::default(),
+        }
+    }
+
+    pub fn predict(
+        &self,
+        backend: &str,
+        queue_length: i32,
+        qpu_seconds: f64,
+    ) -> CompletionPrediction {
+        let history = self
+            .backends
+            .lock()
+            .unwrap()
+            .get(backend)
+            .copied()
+            .unwrap_or_default();
+        CompletionPrediction::new(
+            queue_length.max(0) as f64 * history.seconds_per_queued_job,
+            qpu_seconds * history.qpu_time_scale,
+        )
+    }
+
+    /// Predict the remaining time of a submitted job from its metrics, preferring the service's
+    /// own estimates when it gives them.
+    pub fn predict_job(
+        &self,
+        backend: &str,
+        submission: &SubmissionRecord,
+        metrics: &JobMetrics,
+    ) -> CompletionPrediction {
+        let timestamps = metrics.timestamps.as_deref();
+        if timestamps.and_then(|t| t.finished.as_ref()).is_some() {
+            return CompletionPrediction::default();
+        }
+        let now = now();
+        let estimated_start = parse_time(metrics.estimated_start_time.as_ref());
+        if let Some(completion) = parse_time(metrics.estimated_completion_time.as_ref()) {
+            let queue_wait = estimated_start
+                .map(|start| seconds_between(now, start).max(0.))
+                .unwrap_or(0.);
+            let total = seconds_between(now, completion).max(queue_wait);
+            return CompletionPrediction::new(queue_wait, total - queue_wait);
+        }
+        let running = timestamps.and_then(|t| parse_time(t.running.as_ref()));
+        let prediction = self.predict(
+            backend,
+            metrics.position_in_queue.unwrap_or(0),
+            submission.estimated_qpu_seconds,
+        );
+        match running {
+            Some(running) => CompletionPrediction::new(
+                0.,
+                (prediction.execution - seconds_between(running, now)).max(0.),
+            ),
+            None => prediction,
+        }
+    }
+
+    /// Whether the job `job_id` has already been learned from.
+    pub fn has_learned(&self, job_id: &str) -> bool {
+        self.learned.lock().unwrap().contains(job_id)
+    }
+
+    /// Learn from the metrics of the job `job_id` submitted to `backend`, once it has finished,
+    /// from its actual queue wait and QPU time. Each job is learned from once, however often
+    /// its metrics are observed.
+    pub fn observe(
+        &self,
+        job_id: &str,
+        backend: &str,
+        submission: &SubmissionRecord,
+        metrics: &JobMetrics,
+    ) {
+        let timestamps = metrics.timestamps.as_deref();
+        if timestamps.and_then(|t| t.finished.as_ref()).is_none()
+            || !self.learned.lock().unwrap().insert(job_id.to_string())
+        {
+            return;
+        }
+        let created = timestamps.and_then(|t| parse_time(t.created.as_ref()));
+        let running = timestamps.and_then(|t| parse_time(t.running.as_ref()));
+        let queue_wait_sample = match (created, running) {
+            (Some(created), Some(running)) if submission.queue_length > 0 => {
+                Some(seconds_between(created, running) / submission.queue_length as f64)
+            }
+            _ => None,
+        };
+        let qpu_scale_sample = metrics
+            .usage
+            .as_deref()
+            .and_then(|usage| usage.quantum_seconds)
+            .filter(|_| submission.estimated_qpu_seconds > 0.)
+            .map(|seconds| seconds as f64 / submission.estimated_qpu_seconds);
+        if queue_wait_sample.is_none() && qpu_scale_sample.is_none() {
+            return;
+        }
+
+        let mut backends = self.backends.lock().unwrap();
+        let history = backends.entry(backend.to_string()).or_default();
+        if let Some(sample) = queue_wait_sample {
+            update_average(
+                &mut history.seconds_per_queued_job,
+                &mut history.wait_observations,
+                sample,
+            );
+        }
+        if let Some(sample) = qpu_scale_sample {
+            update_average(
+                &mut history.qpu_time_scale,
+                &mut history.qpu_observations,
+                sample,
+            );
+        }
+        let Some(path) = &self.path else {
+            return;
+        };
+        let file = PredictorFile {
+            version: PREDICTOR_VERSION,
+            backends: backends.clone(),
+        };
+        if let Err(e) = write_json_atomic(path, &file) {
+            log_warn(&format!(
+                "Failed to write predictor state {}: {}",
+                path.display(),
+                e
+            ));
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::qiskit_target::ISAGate;
+
+    fn inst<'a>(name: &str, qubits: &'a [u32]) -> CircuitInstruction<'a> {
+        CircuitInstruction {
+            name: name.to_string(),
+            qubits,
+            clbits: &[],
+            params: &[],
+        }
+    }
+
+    #[test]
+    fn qpu_time_follows_critical_path() {
+        let data = TargetData {
+            num_qubits: 3,
+            gates: vec![
+                (
+                    ISAGate::SX,
+                    (0..3).map(|q| (vec![q], [Some(40e-9), None])).collect(),
+                ),
+                (ISAGate::RZ, vec![(vec![0], [Some(0.), None])]),
+                (
+                    ISAGate::CZ,
+                    vec![
+                        (vec![0, 1], [Some(70e-9), None]),
+                        (vec![1, 2], [None, None]),
+                    ],
+                ),
+            ],
+            measure: (0..3).map(|q| (q, [Some(2e-6), None])).collect(),
+            ..Default::default()
+        };
+        let circuit = [
+            inst("sx", &[0]),
+            inst("rz", &[0]),
+            inst("sx", &[0]),
+            inst("sx", &[2]),
+            inst("cz", &[0, 1]),
+            // Without a reported duration this takes the typical two-qubit duration.
+            inst("cz", &[1, 2]),
+            inst("barrier", &[0, 1, 2]),
+            inst("measure", &[0]),
+            inst("measure", &[1]),
+        ];
+        let estimate = estimate_qpu_time(3, circuit.into_iter(), &data, 1000, 100e-6);
+        let schedule = 2. * 40e-9 + 70e-9 + 100e-9 + 2e-6;
+        assert!((estimate.schedule_seconds - schedule).abs() < 1e-15);
+        assert_eq!(estimate.rep_delay, 100e-6);
+        let total = JOB_OVERHEAD_SECONDS + 1000. * (schedule + 100e-6);
+        assert!((estimate.total_seconds - total).abs() < 1e-12);
+    }
+
+    #[test]
+    fn observed_jobs_update_predictions() {
+        let predictor = Predictor {
+            path: None,
+            backends: Mutex::new(HashMap::new()),
+            learned: Mutex::default(),
+        };
+        let prior = predictor.predict("ibm_test", 2, 5.);
+        assert_eq!(prior.queue_wait, 2. * DEFAULT_SECONDS_PER_QUEUED_JOB);
+        assert_eq!(prior.execution, 5.);
+
+        let submission = SubmissionRecord {
+            queue_length: 4,
+            estimated_qpu_seconds: 5.,
+        };
+        // A queued job has nothing to learn from yet.
+        let queued: JobMetrics = serde_json::from_str(
+            r#"{"position_in_queue": 3, "estimated_start_time": "2025-06-01T12:00:00Z"}"#,
+        )
+        .unwrap();
+        predictor.observe("job-1", "ibm_test", &submission, &queued);
+        assert_eq!(predictor.predict("ibm_test", 2, 5.).total, prior.total);
+        assert!(!predictor.has_learned("job-1"));
+
+        let metrics: JobMetrics = serde_json::from_str(
+            r#"{"timestamps": {"created": "2025-06-01T12:00:00Z",
+                               "running": "2025-06-01T12:03:20Z",
+                               "finished": "2025-06-01T12:03:40Z"},
+                "usage": {"quantum_seconds": 10}}"#,
+        )
+        .unwrap();
+        predictor.observe("job-1", "ibm_test", &submission, &metrics);
+        let learned = predictor.predict("ibm_test", 2, 5.);
+        assert_eq!(learned.queue_wait, 2. * 50.);
+        // Observing the same job again doesn't count it twice.
+        predictor.observe("job-1", "ibm_test", &submission, &metrics);
+        assert_eq!(predictor.predict("ibm_test", 2, 5.).total, learned.total);
+        assert!(predictor.has_learned("job-1"));
+        assert_eq!(learned.execution, 10.);
+        assert_eq!(learned.total, 110.);
+        assert_eq!(
+            predictor
+                .predict_job("ibm_test", &submission, &metrics)
+                .total,
+            0.
+        );
+        // Other backends keep the prior.
+        assert_eq!(predictor.predict("ibm_other", 2, 5.).total, prior.total);
+    }
+}
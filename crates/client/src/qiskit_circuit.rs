@@ -11,9 +11,10 @@
 // that they have been altered from the originals.
 
 use crate::qiskit_ffi;
+use crate::qiskit_target::ISAGate;
 use std::ffi::CStr;
 
-#[derive(Debug)]
+#[derive(Clone, Debug)]
 pub struct CircuitInstruction<'a> {
     pub name: String,
     pub qubits: &'a [u32],
@@ -78,6 +79,45 @@ impl<'a> Iterator for CircuitInstructions<'a> {
 pub struct Circuit(pub *mut qiskit_ffi::QkCircuit);
 
 impl Circuit {
+    pub fn new(num_qubits: u32, num_clbits: u32) -> Self {
+        Circuit(unsafe { qiskit_ffi::qk_circuit_new(num_qubits, num_clbits) })
+    }
+
+    /// Append an ISA instruction, a measurement, a reset or a barrier by name, returning
+    /// whether it was added.
+    pub fn append(&mut self, name: &str, qubits: &[u32], clbits: &[u32], params: &[f64]) -> bool {
+        if qubits.iter().any(|&q| q >= self.num_qubits())
+            || clbits.iter().any(|&c| c >= self.num_clbits())
+        {
+            return false;
+        }
+        let exit_code = unsafe {
+            match (name, qubits, clbits) {
+                ("measure", [qubit], [clbit]) => {
+                    qiskit_ffi::qk_circuit_measure(self.0, *qubit, *clbit)
+                }
+                ("reset", [qubit], []) => qiskit_ffi::qk_circuit_reset(self.0, *qubit),
+                ("barrier", qubits, []) => {
+                    qiskit_ffi::qk_circuit_barrier(self.0, qubits.len() as u32, qubits.as_ptr())
+                }
+                (name, qubits, []) => {
+                    let Some(gate) = ISAGate::from_name(name) else {
+                        return false;
+                    };
+                    let gate = gate as qiskit_ffi::QkGate;
+                    if qubits.len() != qiskit_ffi::qk_gate_num_qubits(gate) as usize
+                        || params.len() != qiskit_ffi::qk_gate_num_params(gate) as usize
+                    {
+                        return false;
+                    }
+                    qiskit_ffi::qk_circuit_gate(self.0, gate, qubits.as_ptr(), params.as_ptr())
+                }
+                _ => return false,
+            }
+        };
+        exit_code == 0
+    }
+
     pub fn num_qubits(&self) -> u32 {
         unsafe { qiskit_ffi::qk_circuit_num_qubits(self.0) }
     }
@@ -438,3 +438,47 @@ unsafe extern "C" {
     #[doc = " @ingroup QkTargetEntry\n Creates a new entry for adding a reset instruction to a ``QkTarget``.\n\n @return A pointer to the new ``QkTargetEntry`` for a reset instruction.\n\n # Example\n\n     QkTargetEntry *entry = qk_target_entry_new_reset();\n     // Add fixed duration and error rates from qubits at index 0 to 2.\n     for (uint32_t i = 0; i < 3; i++) {\n         // Reset is a single qubit instruction\n         uint32_t qargs[1] = {i};\n         qk_target_entry_add_property(entry, qargs, 1, 1.2e-11, 5.9e-13);\n     }\n\n     // Add the entry to a target with 3 qubits\n     QkTarget *reset_target = qk_target_new(3);\n     qk_target_add_instruction(reset_target, entry);"]
     pub fn qk_target_entry_new_reset() -> *mut QkTargetEntry;
 }
+
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct QkTranspileLayout {
+    _unused: [u8; 0],
+}
+#[doc = " The options for running the transpiler"]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct QkTranspileOptions {
+    #[doc = " The optimization level to run the transpiler with. Valid values are 0, 1, 2, or 3."]
+    pub optimization_level: u8,
+    #[doc = " The seed for the transpiler. If set to a negative number this means no seed will be\n set and the RNGs used in the transpiler will be seeded from system entropy."]
+    pub seed: i64,
+    #[doc = " The approximation degree a heurstic dial where 1.0 means no approximation (up to\n numerical tolerance) and 0.0 means the maximum approximation. A `NAN` value indicates\n that approximation is allowed up to the reported error rate for an operation in the\n target."]
+    pub approximation_degree: f64,
+}
+#[doc = " The container result object from ``qk_transpile``\n\n When the transpiler successfully compiles a quantum circuit for a given target it\n returns the transpiled circuit and the layout."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct QkTranspileResult {
+    #[doc = " The compiled circuit."]
+    pub circuit: *mut QkCircuit,
+    #[doc = " Metadata about the initial and final virtual to physical layouts."]
+    pub layout: *mut QkTranspileLayout,
+}
+unsafe extern "C" {
+    #[doc = " @ingroup QkTranspiler\n Generate transpiler options defaults\n\n This function generates a QkTranspileOptions with the default settings\n This currently is ``optimization_level`` 2, no seed, and no approximation."]
+    pub fn qk_transpiler_default_options() -> QkTranspileOptions;
+}
+unsafe extern "C" {
+    #[doc = " @ingroup QkTranspiler\n Transpile a single circuit.\n\n The Qiskit transpiler is a quantum circuit compiler that rewrites a given\n input circuit to match the constraints of a QPU and optimizes the circuit\n for execution.\n\n @param circuit A pointer to the circuit to run the transpiler on.\n @param target A pointer to the target to compile the circuit for.\n @param options A pointer to an options object that defines user options. If this is a null\n   pointer the default values will be used.\n @param result A pointer to the memory location of the transpiler result. On a successful\n   execution (return code 0) the output of the transpiler will be written to the pointer.\n @param error A pointer to a pointer with an nul terminated string with an error description.\n   If the transpiler fails a pointer to the string with the error description will be written\n   to this pointer. That pointer needs to be freed with ``qk_str_free``. This can be a null\n   pointer in which case the error will not be written out.\n\n @returns The return code for the transpiler, ``QkExitCode_Success`` means success and all\n   other values indicate an error."]
+    pub fn qk_transpile(
+        circuit: *const QkCircuit,
+        target: *const QkTarget,
+        options: *const QkTranspileOptions,
+        result: *mut QkTranspileResult,
+        error: *mut *mut ::std::os::raw::c_char,
+    ) -> QkExitCode;
+}
+unsafe extern "C" {
+    #[doc = " @ingroup QkTranspileLayout\n Free a ``QkTranspileLayout`` object\n\n @param layout a pointer to the layout to free"]
+    pub fn qk_transpile_layout_free(layout: *mut QkTranspileLayout);
+}
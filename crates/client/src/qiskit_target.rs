@@ -10,9 +10,12 @@
 // copyright notice, and modified files need to carry a notice indicating
 // that they have been altered from the originals.
 
+use serde::{Deserialize, Serialize};
+
 use crate::qiskit_ffi;
 
 #[repr(u8)]
+#[derive(Copy, Clone, Debug, PartialEq, Eq, Hash, Deserialize, Serialize)]
 pub enum ISAGate {
     X = 3,
     SX = 13,
@@ -25,8 +28,30 @@ pub enum ISAGate {
     RZZ = 41,
 }
 
+impl ISAGate {
+    /// The gate with the given name in backend properties, if it is one of the ISA gates.
+    pub fn from_name(name: &str) -> Option<Self> {
+        Some(match name {
+            "x" => ISAGate::X,
+            "sx" => ISAGate::SX,
+            "cz" => ISAGate::CZ,
+            "ecr" => ISAGate::ECR,
+            "rz" => ISAGate::RZ,
+            "rx" => ISAGate::RX,
+            "id" => ISAGate::I,
+            "cx" => ISAGate::CX,
+            "rzz" => ISAGate::RZZ,
+            _ => return None,
+        })
+    }
+}
+
+#[derive(Debug)]
 pub struct Target(pub(crate) *mut qiskit_ffi::QkTarget);
 
+// The target is exclusively owned by this handle, so moving it to another thread is sound.
+unsafe impl Send for Target {}
+
 impl Drop for Target {
     fn drop(&mut self) {
         unsafe {
@@ -40,6 +65,11 @@ impl Target {
         Target(unsafe { qiskit_ffi::qk_target_new(num_qubits) })
     }
 
+    /// An independent copy of this target.
+    pub fn copy(&self) -> Self {
+        Target(unsafe { qiskit_ffi::qk_target_copy(self.0) })
+    }
+
     pub fn set_dt(&mut self, dt: f64) {
         unsafe {
             qiskit_ffi::qk_target_set_dt(self.0, dt);
@@ -66,6 +96,28 @@ impl Target {
         }
     }
 
+    /// Set the duration and error of `gate` on `qargs` in place, returning whether the target
+    /// has that instruction.
+    pub fn update_property(
+        &mut self,
+        gate: ISAGate,
+        qargs: &[u32],
+        [duration, error]: [Option<f64>; 2],
+    ) -> bool {
+        let mut qargs = qargs.to_vec();
+        let code = unsafe {
+            qiskit_ffi::qk_target_update_property(
+                self.0,
+                gate as u8,
+                qargs.as_mut_ptr(),
+                qargs.len() as u32,
+                duration.unwrap_or(f64::NAN),
+                error.unwrap_or(f64::NAN),
+            )
+        };
+        code == 0
+    }
+
     pub fn add_measure(
         &mut self,
         error_duration_map: impl Iterator<Item = (u32, [Option<f64>; 2])>,
@@ -32,17 +32,6 @@ pub struct ProgramType {
     pub type_key: u8,
 }
 
-/// The overall structure of the QPY file
-#[derive(BinWrite)]
-#[brw(big)]
-pub struct QPYFormatV13 {
-    pub header: CircuitHeaderV12Pack,
-    pub custom_instructions: CustomCircuitInstructionsPack,
-    pub instructions: Vec<CircuitInstructionV2Pack>,
-    pub calibration_header: Bytes,
-    pub layout: LayoutV2Pack,
-}
-
 #[derive(BinWrite)]
 #[brw(big)]
 pub struct CircuitHeaderV12Pack {
@@ -0,0 +1,299 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Choosing the connected region of a backend with the lowest errors.
+//!
+//! The coupling map is weighted with the two-qubit gate error of each edge and the readout error
+//! of each qubit, both as ``-ln(1 - error)`` so that costs add up like infidelities. A region is
+//! scored by the mean cost of the edges between its qubits and the mean cost of its qubits'
+//! readout. Searching every connected region is exponential, so a region is grown greedily from
+//! each qubit in turn, always adding the neighbouring qubit that keeps the score lowest, and the
+//! best region found is kept.
+
+use std::collections::HashMap;
+
+use crate::backend_data::TargetData;
+
+/// What [best_subset] minimizes.
+#[derive(Copy, Clone, Debug, Default, PartialEq, Eq)]
+#[repr(u32)]
+pub enum SubsetObjective {
+    /// Two-qubit gate and readout errors, weighted equally.
+    #[default]
+    Balanced = 0,
+    /// Only two-qubit gate errors.
+    TwoQubit = 1,
+    /// Only readout errors.
+    Readout = 2,
+}
+
+impl TryFrom<u32> for SubsetObjective {
+    type Error = u32;
+
+    fn try_from(value: u32) -> Result<Self, u32> {
+        match value {
+            0 => Ok(SubsetObjective::Balanced),
+            1 => Ok(SubsetObjective::TwoQubit),
+            2 => Ok(SubsetObjective::Readout),
+            _ => Err(value),
+        }
+    }
+}
+
+impl SubsetObjective {
+    /// The weights of the two-qubit and readout costs.
+    fn weights(self) -> (f64, f64) {
+        match self {
+            SubsetObjective::Balanced => (1., 1.),
+            SubsetObjective::TwoQubit => (1., 0.),
+            SubsetObjective::Readout => (0., 1.),
+        }
+    }
+}
+
+/// The cost of an operation with the given error rate. An unknown (NaN) error counts as a broken
+/// operation, so regions avoid it whenever they can.
+fn error_cost(error: f64) -> f64 {
+    let error = if error.is_finite() { error } else { 1. };
+    -(1. - error.clamp(0., 1. - 1e-6)).ln()
+}
+
+/// The coupling map of a backend with the cost of each edge and qubit.
+struct ErrorGraph {
+    neighbours: Vec<Vec<(u32, f64)>>,
+    readout: Vec<f64>,
+}
+
+impl ErrorGraph {
+    /// Weight each pair of coupled qubits with the lowest cost of a two-qubit gate between them,
+    /// in either direction.
+    fn new(data: &TargetData) -> Self {
+        let map = data.coupling_map();
+        let mut edges: HashMap<(u32, u32), f64> = HashMap::new();
+        for a in 0..data.num_qubits {
+            let row = map.offsets[a as usize] as usize..map.offsets[a as usize + 1] as usize;
+            for (&b, &error) in map.columns[row.clone()].iter().zip(&map.edge_error[row]) {
+                let cost = edges.entry((a.min(b), a.max(b))).or_insert(f64::INFINITY);
+                *cost = cost.min(error_cost(error));
+            }
+        }
+        let mut neighbours = vec![Vec::new(); data.num_qubits as usize];
+        for ((a, b), cost) in edges {
+            neighbours[a as usize].push((b, cost));
+            neighbours[b as usize].push((a, cost));
+        }
+        // Sort for a search that doesn't depend on hash order.
+        for list in &mut neighbours {
+            list.sort_unstable_by_key(|(qubit, _)| *qubit);
+        }
+        ErrorGraph {
+            neighbours,
+            readout: map.readout_error.iter().map(|&x| error_cost(x)).collect(),
+        }
+    }
+
+    /// Grow a connected region of `k` qubits from `seed`, or return `None` if the seed's
+    /// connected component is too small.
+    fn grow(&self, seed: u32, k: usize, weights: (f64, f64)) -> Option<(f64, Vec<u32>)> {
+        let mut in_region = vec![false; self.readout.len()];
+        in_region[seed as usize] = true;
+        let mut region = vec![seed];
+        let mut edge_cost = 0.;
+        let mut num_edges = 0usize;
+        let mut readout_cost = self.readout[seed as usize];
+        let score = |edge_cost: f64, num_edges: usize, readout_cost: f64, size: usize| {
+            let edges = if num_edges == 0 {
+                0.
+            } else {
+                edge_cost / num_edges as f64
+            };
+            weights.0 * edges + weights.1 * readout_cost / size as f64
+        };
+        while region.len() < k {
+            let mut best: Option<(f64, u32, f64, usize)> = None;
+            for &member in &region {
+                for &(candidate, _) in &self.neighbours[member as usize] {
+                    if in_region[candidate as usize] {
+                        continue;
+                    }
+                    let (added_cost, added_edges) = self.neighbours[candidate as usize]
+                        .iter()
+                        .filter(|(other, _)| in_region[*other as usize])
+                        .fold((0., 0), |(cost, count), (_, c)| (cost + c, count + 1));
+                    let candidate_score = score(
+                        edge_cost + added_cost,
+                        num_edges + added_edges,
+                        readout_cost + self.readout[candidate as usize],
+                        region.len() + 1,
+                    );
+                    let better = best.map_or(true, |(best_score, qubit, _, _)| {
+                        candidate_score < best_score
+                            || (candidate_score == best_score && candidate < qubit)
+                    });
+                    if better {
+                        best = Some((candidate_score, candidate, added_cost, added_edges));
+                    }
+                }
+            }
+            let (_, qubit, added_cost, added_edges) = best?;
+            in_region[qubit as usize] = true;
+            region.push(qubit);
+            edge_cost += added_cost;
+            num_edges += added_edges;
+            readout_cost += self.readout[qubit as usize];
+        }
+        region.sort_unstable();
+        Some((score(edge_cost, num_edges, readout_cost, k), region))
+    }
+}
+
+/// Find a connected region of `k` qubits with low errors, as sorted physical qubit indices.
+pub(crate) fn best_subset(
+    data: &TargetData,
+    k: u32,
+    objective: SubsetObjective,
+) -> Result<Vec<u32>, String> {
+    if k == 0 || k > data.num_qubits {
+        return Err(format!(
+            "Cannot choose {} qubits from a backend with {}",
+            k, data.num_qubits
+        ));
+    }
+    let graph = ErrorGraph::new(data);
+    let weights = objective.weights();
+    let mut best: Option<(f64, Vec<u32>)> = None;
+    for seed in 0..data.num_qubits {
+        let Some((score, region)) = graph.grow(seed, k as usize, weights) else {
+            continue;
+        };
+        if best
+            .as_ref()
+            .map_or(true, |(best_score, _)| score < *best_score)
+        {
+            best = Some((score, region));
+        }
+    }
+    best.map(|(_, region)| region)
+        .ok_or_else(|| format!("The backend has no {} connected qubits", k))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::qiskit_target::ISAGate;
+
+    /// A line of `n` qubits with the given CZ errors between neighbours and readout errors.
+    fn line(cz: &[f64], readout: &[f64]) -> TargetData {
+        let pairs = cz.iter().enumerate().flat_map(|(q, &error)| {
+            let q = q as u32;
+            [
+                (vec![q, q + 1], [Some(60e-9), Some(error)]),
+                (vec![q + 1, q], [Some(60e-9), Some(error)]),
+            ]
+        });
+        TargetData {
+            num_qubits: readout.len() as u32,
+            gates: vec![(ISAGate::CZ, pairs.collect())],
+            measure: (0..)
+                .zip(readout)
+                .map(|(q, &error)| (q, [Some(1e-6), Some(error)]))
+                .collect(),
+            ..Default::default()
+        }
+    }
+
+    #[test]
+    fn subset_objective_from_u32() {
+        for objective in [
+            SubsetObjective::Balanced,
+            SubsetObjective::TwoQubit,
+            SubsetObjective::Readout,
+        ] {
+            assert_eq!(SubsetObjective::try_from(objective as u32), Ok(objective));
+        }
+        assert_eq!(SubsetObjective::try_from(3), Err(3));
+    }
+
+    #[test]
+    fn best_subset_avoids_noisy_couplers_and_readout() {
+        //             0 - 1 - 2 - 3 - 4 - 5
+        let cz = [0.002, 0.003, 0.2, 0.003, 0.002];
+        let readout = [0.01, 0.01, 0.01, 0.01, 0.3, 0.01];
+        let data = line(&cz, &readout);
+        assert_eq!(
+            best_subset(&data, 3, SubsetObjective::Balanced),
+            Ok(vec![0, 1, 2])
+        );
+        assert_eq!(
+            best_subset(&data, 3, SubsetObjective::TwoQubit),
+            Ok(vec![0, 1, 2])
+        );
+        assert_eq!(
+            best_subset(&data, 2, SubsetObjective::TwoQubit),
+            Ok(vec![0, 1])
+        );
+        assert_eq!(
+            best_subset(&data, 4, SubsetObjective::Readout),
+            Ok(vec![0, 1, 2, 3])
+        );
+        assert_eq!(
+            best_subset(&data, 6, SubsetObjective::Balanced),
+            Ok((0..6).collect())
+        );
+        assert!(best_subset(&data, 0, SubsetObjective::Balanced).is_err());
+        assert!(best_subset(&data, 7, SubsetObjective::Balanced).is_err());
+
+        // Without the 2 - 3 coupler no region spans both halves.
+        let mut split = line(&cz, &readout);
+        split.gates[0]
+            .1
+            .retain(|(qargs, _)| !qargs.contains(&2) || !qargs.contains(&3));
+        assert!(best_subset(&split, 4, SubsetObjective::Balanced).is_err());
+    }
+
+    #[test]
+    fn restricted_target_data_is_renumbered() {
+        let data = line(&[0.002, 0.003, 0.004], &[0.01, 0.02, 0.03, 0.04]);
+        let restricted = data.restrict(&[1, 2]);
+        assert_eq!(restricted.num_qubits, 2);
+        assert_eq!(
+            restricted.gates[0].1,
+            vec![
+                (vec![0, 1], [Some(60e-9), Some(0.003)]),
+                (vec![1, 0], [Some(60e-9), Some(0.003)]),
+            ]
+        );
+        assert_eq!(
+            restricted.measure,
+            vec![(0, [Some(1e-6), Some(0.02)]), (1, [Some(1e-6), Some(0.03)])]
+        );
+    }
+
+    #[test]
+    fn best_subset_of_heron() {
+        let (configuration, properties) = crate::backend_data::tests::heron_documents();
+        let data = TargetData::parse(&configuration, &properties).unwrap();
+        let region = best_subset(&data, 72, SubsetObjective::Balanced).unwrap();
+        assert_eq!(region.len(), 72);
+        assert!(region.windows(2).all(|x| x[0] < x[1]));
+        let restricted = data.restrict(&region);
+        assert_eq!(restricted.num_qubits, 72);
+        assert_eq!(restricted.measure.len(), 72);
+        // The region is connected, so it has at least a spanning tree of couplers in each
+        // direction.
+        assert!(restricted
+            .gates
+            .iter()
+            .any(|(gate, props)| *gate == ISAGate::CZ
+                && props.iter().filter(|(qargs, _)| qargs.len() == 2).count() >= 2 * 71));
+    }
+}
@@ -16,21 +16,39 @@ use std::io::BufReader;
 use std::path::Path;
 
 use ibm_quantum_platform_api::apis::backends_api::{
-    get_backend_configuration, get_backend_properties, list_backends,
+    get_backend_configuration_bytes, get_backend_properties_bytes, get_backend_status,
+    list_backends,
 };
+use ibm_quantum_platform_api::apis::instances_api::get_usage;
 use ibm_quantum_platform_api::apis::jobs_api::{
-    create_job, get_job_details_jid, get_job_results_jid,
+    create_job, get_job_details_jid, get_job_metrics_jid, get_job_results_jid,
 };
+use ibm_quantum_platform_api::apis::workloads_api::find_instance_workloads;
 use ibm_quantum_platform_api::models::{
     BackendsResponseV2DevicesInner, CreateJob200Response, CreateJobRequest,
 };
 use ibmcloud_global_search_api::apis::configuration::Configuration as SearchConfiguration;
 use ibmcloud_global_search_api::apis::search_api::search;
+use ibmcloud_global_search_api::models::{FirstCall, NextCall, ResultItem, SearchRequest};
 use ibmcloud_iam_api::apis::configuration::Configuration;
 use ibmcloud_iam_api::apis::token_operations_api::get_token_api_key;
 use ibmcloud_iam_api::models::token_response::TokenResponse;
 
-use crate::{log_debug, log_warn, ExitCode};
+use crate::backend_data::{BackendConfiguration, TargetData, TargetRefresh, WeightedCouplingMap};
+use crate::cache::{DiscoveryCache, TargetCache, TranspileCache};
+use crate::fidelity::CircuitOperations;
+use crate::isa::{validate_isa, IsaReport};
+use crate::pipeline::{Pipeline, PipelineOptions};
+use crate::predictor::{
+    estimate_qpu_seconds, estimate_qpu_time, CompletionPrediction, Predictor, QpuTimeEstimate,
+    SubmissionRecord, DEFAULT_SHOTS, REP_DELAY_SECONDS,
+};
+use crate::qiskit_ffi::{QkTranspileOptions, QkTranspileResult};
+use crate::qiskit_target::Target;
+use crate::qubit_subset::{best_subset, SubsetObjective};
+use crate::transpile::{TranspileSelection, TranspileTrial};
+use crate::{log_debug, log_info, log_warn, ExitCode};
+use futures::{Stream, StreamExt, TryStreamExt};
 use ibm_quantum_platform_api::models;
 use ibm_quantum_platform_api::models::job_response::Status;
 use ibm_quantum_platform_api::models::SamplerV2Result;
@@ -38,6 +56,11 @@ use std::collections::HashMap;
 use std::error;
 use std::ffi::{c_char, CString};
 use std::fmt::{Debug, Display, Formatter};
+use std::sync::atomic::{AtomicI32, AtomicU32, Ordering};
+use std::sync::mpsc::{self, RecvTimeoutError};
+use std::sync::{Arc, Mutex, OnceLock};
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant, SystemTime};
 
 #[derive(Deserialize, Serialize, Clone, Debug)]
 pub struct AccountEntry {
@@ -63,6 +86,8 @@ struct ProxyConfiguration {
 pub struct Job {
     instance: Instance,
     response: CreateJob200Response,
+    backend: String,
+    submission: SubmissionRecord,
 }
 
 #[derive(Clone, Debug)]
@@ -95,18 +120,102 @@ impl JobDetails {
     }
 }
 
+#[derive(Copy, Clone, Debug, PartialEq, Eq)]
+#[repr(u32)]
+pub enum BackendStatus {
+    Online = 0,
+    Paused = 1,
+    Offline = 2,
+}
+
+impl BackendStatus {
+    fn from_u32(value: u32) -> Self {
+        match value {
+            0 => BackendStatus::Online,
+            1 => BackendStatus::Paused,
+            _ => BackendStatus::Offline,
+        }
+    }
+
+    fn from_status_response(resp: &models::BackendStatusResponse) -> Self {
+        if resp.state == Some(false) {
+            return BackendStatus::Offline;
+        }
+        match resp.status.as_deref().map(|x| x.to_lowercase()).as_deref() {
+            Some("paused") => BackendStatus::Paused,
+            Some("offline") | Some("internal") | Some("maintenance") => BackendStatus::Offline,
+            _ => BackendStatus::Online,
+        }
+    }
+}
+
+impl From<models::backends_response_v2_devices_inner_status::Name> for BackendStatus {
+    fn from(value: models::backends_response_v2_devices_inner_status::Name) -> Self {
+        use models::backends_response_v2_devices_inner_status::Name;
+        match value {
+            Name::Online => BackendStatus::Online,
+            Name::Paused => BackendStatus::Paused,
+            Name::Offline => BackendStatus::Offline,
+        }
+    }
+}
+
+/// The fields of a backend that change between searches. They are shared by every clone of a
+/// [Backend] so refreshing them updates handles the caller already holds.
+#[derive(Debug)]
+struct LiveStatus {
+    queue_length: AtomicI32,
+    status: AtomicU32,
+}
+
 #[derive(Clone, Debug)]
 pub struct Backend {
     pub(crate) name: CString,
     instance: Instance,
     response: BackendsResponseV2DevicesInner,
+    live: Arc<LiveStatus>,
+    // Why `instance` was chosen, if the backend is reachable from several instances.
+    instance_load: InstanceLoad,
+    // Every instance the backend is reachable from if one was chosen among several, so the
+    // choice can be made again when a job is submitted.
+    candidates: Arc<[Instance]>,
 }
 
 impl Backend {
+    fn new(instance: Instance, response: BackendsResponseV2DevicesInner) -> Self {
+        let live = Arc::new(LiveStatus {
+            queue_length: AtomicI32::new(response.queue_length),
+            status: AtomicU32::new(BackendStatus::from(response.status.name) as u32),
+        });
+        Backend {
+            name: CString::new(response.name.as_str()).unwrap(),
+            instance,
+            response,
+            live,
+            instance_load: InstanceLoad::default(),
+            candidates: Arc::from(Vec::new()),
+        }
+    }
+
     pub fn name(&self) -> *const c_char {
         self.name.as_ptr()
     }
 
+    pub fn queue_length(&self) -> i32 {
+        self.live.queue_length.load(Ordering::Relaxed)
+    }
+
+    pub fn status(&self) -> BackendStatus {
+        BackendStatus::from_u32(self.live.status.load(Ordering::Relaxed))
+    }
+
+    fn update_live(&self, queue_length: i32, status: BackendStatus) {
+        self.live
+            .queue_length
+            .store(queue_length, Ordering::Relaxed);
+        self.live.status.store(status as u32, Ordering::Relaxed);
+    }
+
     pub fn instance_name(&self) -> *const c_char {
         self.instance.name.as_ptr()
     }
@@ -114,6 +223,38 @@ impl Backend {
     pub fn instance_crn(&self) -> *const c_char {
         self.instance.crn.as_ptr()
     }
+
+    pub fn instance_load(&self) -> InstanceLoad {
+        self.instance_load
+    }
+}
+
+/// The load of the instance a backend is used through, as considered when choosing between
+/// several instances that reach the same backend.
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default)]
+pub struct InstanceLoad {
+    /// The number of instances the backend was reachable from, or 0 if none was chosen.
+    pub candidates: u32,
+    /// Pending and in-progress workloads of the instance on the backend.
+    pub active_workloads: u32,
+    pub usage_consumed_seconds: f64,
+    /// The usage limit of the instance, or 0 if it has none.
+    pub usage_limit_seconds: f64,
+    pub usage_limit_reached: bool,
+}
+
+impl InstanceLoad {
+    /// Order instances by preference: under their usage limit, then fewest active workloads,
+    /// then the smallest fraction of their usage limit consumed.
+    fn preference(&self) -> (bool, u32, f64) {
+        let usage = if self.usage_limit_seconds > 0. {
+            self.usage_consumed_seconds / self.usage_limit_seconds
+        } else {
+            0.
+        };
+        (self.usage_limit_reached, self.active_workloads, usage)
+    }
 }
 
 // Note: this cannot simply derive Clone since the ptrs cache would be wrong
@@ -132,19 +273,112 @@ impl BackendSearchResults {
         self.ptrs.len()
     }
 
+    pub fn backends(&self) -> impl Iterator<Item = &Backend> {
+        self.backends.iter().map(|b| b.as_ref())
+    }
+
+    /// Build the targets of the first `top_n` backends, or all of them if 0, in the background.
+    /// See [Service::spawn_target_prefetch].
+    pub fn prefetch_targets(&self, service: &Service, top_n: usize, max_concurrent: usize) {
+        let top_n = if top_n == 0 { usize::MAX } else { top_n };
+        let backends = self
+            .backends()
+            .take(top_n)
+            .map(|backend| {
+                (
+                    backend.response.name.clone(),
+                    backend.instance.crn.to_str().unwrap().to_string(),
+                )
+            })
+            .collect();
+        service.spawn_target_prefetch(backends, max_concurrent);
+    }
+
+    /// The backend predicted to return the results of `circuit` soonest.
+    pub fn least_time(
+        &self,
+        service: &Service,
+        circuit: &crate::qiskit_circuit::Circuit,
+        shots: Option<i32>,
+    ) -> *const Backend {
+        let qpu_seconds = estimate_qpu_seconds(circuit, shots.unwrap_or(DEFAULT_SHOTS));
+        let predictor = service.predictor();
+        self.backends
+            .iter()
+            .map(|b| {
+                let prediction = predictor.predict(&b.response.name, b.queue_length(), qpu_seconds);
+                (prediction.total, b)
+            })
+            .min_by(|a, b| a.0.total_cmp(&b.0))
+            .map(|(_, b)| b.as_ref() as *const Backend)
+            .unwrap_or(std::ptr::null())
+    }
+
     pub fn least_busy(&self) -> *const Backend {
         self.backends
             .iter()
-            .min_by_key(|b| b.response.queue_length)
+            .min_by_key(|b| b.queue_length())
             .map(|b| b.as_ref() as *const Backend)
             .unwrap_or(std::ptr::null())
     }
 }
 
+/// The backends visible through each instance, as returned by the backend listing.
+pub type BackendListing = Vec<(Instance, BackendsResponseV2DevicesInner)>;
+
+/// The instance chosen for a backend reachable from several, see [balance_listing].
+#[derive(Clone, Debug)]
+struct InstanceChoice {
+    load: InstanceLoad,
+    candidates: Arc<[Instance]>,
+}
+
+impl BackendSearchResults {
+    fn from_listing(listing: BackendListing, choices: &HashMap<String, InstanceChoice>) -> Self {
+        let backends: Vec<Box<Backend>> = listing
+            .into_iter()
+            .map(|(instance, response)| {
+                let mut backend = Backend::new(instance, response);
+                if let Some(choice) = choices.get(&backend.response.name) {
+                    backend.instance_load = choice.load;
+                    backend.candidates = choice.candidates.clone();
+                }
+                Box::new(backend)
+            })
+            .collect();
+        let ptrs = backends
+            .iter()
+            .map(|b| b.as_ref() as *const Backend)
+            .collect();
+        BackendSearchResults { backends, ptrs }
+    }
+}
+
+/// Wall-clock seconds spent in each phase of bringing up a [Service].
+///
+/// Phases that run in the background, or lazily on first use, are zero until they complete.
+/// Because some phases overlap, the phase times need not add up to ``total``.
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default)]
+pub struct StartupTimings {
+    /// Reading and parsing the account configuration file.
+    pub config: f64,
+    /// Exchanging the API key for an IAM access token.
+    pub iam_token: f64,
+    /// Resolving the instances the service submits through.
+    pub instance_discovery: f64,
+    /// Listing the backends of every instance.
+    pub backend_listing: f64,
+    /// Fetching and building the targets of the listed backends.
+    pub target_prefetch: f64,
+    /// Time until the service handle was returned to the caller.
+    pub total: f64,
+}
+
 #[derive(Clone, Debug)]
 pub struct ServiceError {
-    code: ExitCode,
-    message: String,
+    pub(crate) code: ExitCode,
+    pub(crate) message: String,
 }
 
 impl ServiceError {
@@ -258,25 +492,251 @@ fn get_account_config(filename: Option<&str>, name: Option<&str>) -> AccountEntr
 #[derive(Clone, Debug)]
 pub struct Service {
     account: Account,
-    instances: Vec<Instance>,
+    // Resolved on first use by `Service::instances` unless provided up front.
+    instances: Arc<OnceLock<Vec<Instance>>>,
     quantum_config: ibm_quantum_platform_api::apis::configuration::Configuration,
+    timings: Arc<Mutex<StartupTimings>>,
+    // Background backend listing started by `Service::spawn_prefetch`, consumed by the first
+    // backend search.
+    backend_prefetch: Arc<Mutex<Option<JoinHandle<Option<BackendListing>>>>>,
+    // Built targets, reused until the backend's calibration moves.
+    target_cache: TargetCache,
+    // Transpiled circuits, reused for the same circuit, options and calibration.
+    transpile_cache: TranspileCache,
+    discovery_cache: Option<DiscoveryCache>,
+    // The listing loaded from or last written to `discovery_cache`, with its creation time.
+    cached_backends: Arc<Mutex<Option<(SystemTime, BackendListing)>>>,
+    // Learned queue and execution times, loaded from disk on first use.
+    predictor: Arc<OnceLock<Predictor>>,
+    // Keep one entry per backend in search results, through the least loaded instance.
+    balance_instances: bool,
+    // Instance loads by instance CRN and backend name, with when they were fetched.
+    instance_loads: Arc<Mutex<HashMap<(String, String), (Instant, InstanceLoad)>>>,
+    // How long an entry of `instance_loads` is used before the load is fetched again.
+    instance_load_ttl: Duration,
+    // Check circuits against the backend's instructions before submitting them.
+    validate_isa: bool,
 }
 
 impl Service {
     pub fn new(account: Account, instances: Vec<Instance>) -> Self {
+        let service = Service::new_lazy(account);
+        service.instances.set(instances).unwrap();
+        service
+    }
+
+    /// Create a service whose instance discovery is deferred until the instances are first
+    /// needed (typically the first backend search).
+    pub fn new_lazy(account: Account) -> Self {
         let mut quantum_config =
             ibm_quantum_platform_api::apis::configuration::Configuration::default();
+        quantum_config.client = account.iam_config.client.clone();
         quantum_config.user_agent = Some("qiskit-ibm-runtime-rs/0.0.1".to_string());
-        quantum_config.api_key = Some(ibm_quantum_platform_api::apis::configuration::ApiKey {
-            key: account.get_access_token().unwrap().to_string(),
-            prefix: Some("Bearer".to_string()),
-        });
+        quantum_config.api_key = Some(quantum_api_key(account.get_access_token().unwrap()));
 
         Service {
             account,
-            instances,
+            instances: Arc::new(OnceLock::new()),
             quantum_config,
+            timings: Arc::new(Mutex::new(StartupTimings::default())),
+            backend_prefetch: Arc::new(Mutex::new(None)),
+            target_cache: TargetCache::new(),
+            transpile_cache: TranspileCache::new(),
+            discovery_cache: None,
+            cached_backends: Arc::new(Mutex::new(None)),
+            predictor: Arc::new(OnceLock::new()),
+            balance_instances: false,
+            instance_loads: Arc::new(Mutex::new(HashMap::new())),
+            instance_load_ttl: INSTANCE_LOAD_TTL,
+            validate_isa: false,
+        }
+    }
+
+    /// When a backend is reachable from several instances, list it once in search results,
+    /// through the instance with the least load, and choose again from those instances when a
+    /// job is submitted to it. Choosing costs two requests per candidate instance whose load
+    /// wasn't fetched in the last [INSTANCE_LOAD_TTL].
+    pub fn enable_instance_balancing(&mut self) {
+        self.balance_instances = true;
+    }
+
+    /// Check every circuit against the target data of its backend before submitting it, and
+    /// fail the submission locally if the circuit isn't an ISA circuit for the backend.
+    pub fn enable_isa_validation(&mut self) {
+        self.validate_isa = true;
+    }
+
+    fn predictor(&self) -> &Predictor {
+        self.predictor.get_or_init(Predictor::load)
+    }
+
+    /// Serve instance discovery and backend listings from an on-disk cache that expires after
+    /// `ttl`. A warm cache is loaded immediately.
+    pub fn enable_discovery_cache(&mut self, ttl: Duration) {
+        let Some(cache) = DiscoveryCache::new(&self.account.config, ttl) else {
+            return;
+        };
+        if let Some(cached) = cache.load() {
+            if self.instances.get().is_none() {
+                self.instances = Arc::new(OnceLock::from(cached.instances));
+            }
+            *self.cached_backends.lock().unwrap() = Some((cached.created, cached.listing));
+        }
+        self.discovery_cache = Some(cache);
+    }
+
+    /// The cached backend listing, if the discovery cache is enabled and has not expired.
+    fn cached_backends(&self) -> Option<BackendListing> {
+        let cache = self.discovery_cache.as_ref()?;
+        match self.cached_backends.lock().unwrap().as_ref() {
+            Some((created, listing)) if cache.is_fresh(*created) => Some(listing.clone()),
+            _ => None,
+        }
+    }
+
+    fn store_cached_backends(&self, instances: &[Instance], listing: &BackendListing) {
+        if let Some(cache) = &self.discovery_cache {
+            cache.store(instances, listing);
+            *self.cached_backends.lock().unwrap() = Some((SystemTime::now(), listing.clone()));
+        }
+    }
+
+    /// Drop all cached discovery state and rediscover instances and backends.
+    ///
+    /// With the discovery cache enabled the fresh listing is fetched now and persisted;
+    /// otherwise discovery reruns on the next backend search.
+    pub async fn refresh(&mut self) -> Result<(), ServiceError> {
+        // Don't let an in-flight prefetch hand out a listing from before the refresh.
+        drop(self.take_prefetched_backends());
+        self.instances = Arc::new(OnceLock::new());
+        *self.cached_backends.lock().unwrap() = None;
+        if let Some(cache) = &self.discovery_cache {
+            cache.clear();
+            list_all_backends(self).await?;
+        }
+        Ok(())
+    }
+
+    pub fn timings(&self) -> StartupTimings {
+        *self.timings.lock().unwrap()
+    }
+
+    fn record_timing(&self, f: impl FnOnce(&mut StartupTimings)) {
+        f(&mut *self.timings.lock().unwrap())
+    }
+
+    /// List the backends, and optionally build their targets, on a background thread so that
+    /// the first backend search and target requests are served without waiting on the network.
+    pub fn spawn_prefetch(&self, targets: bool) {
+        let service = self.clone();
+        let handle = std::thread::spawn(move || {
+            let rt = tokio::runtime::Builder::new_current_thread()
+                .enable_all()
+                .build()
+                .unwrap();
+            let listing = match service.cached_backends() {
+                Some(listing) => listing,
+                None => match rt.block_on(list_all_backends(&service)) {
+                    Ok(listing) => listing,
+                    Err(e) => {
+                        log_warn(&format!("Backend prefetch failed: {}", e));
+                        return None;
+                    }
+                },
+            };
+            if targets {
+                let names: Vec<(String, String)> = listing
+                    .iter()
+                    .map(|(instance, device)| {
+                        (
+                            device.name.clone(),
+                            instance.crn.to_str().unwrap().to_string(),
+                        )
+                    })
+                    .collect();
+                // Target building must not hold up the first backend search, which only
+                // needs the listing.
+                service.spawn_target_prefetch(names, DEFAULT_PREFETCH_CONCURRENCY);
+            }
+            Some(listing)
+        });
+        *self.backend_prefetch.lock().unwrap() = Some(handle);
+    }
+
+    /// Build the targets of `backends`, given as name and instance CRN, into the target cache
+    /// on a background thread, fetching at most `max_concurrent` backends at once.
+    ///
+    /// Backends beyond the capacity of the target cache are skipped, as they would only evict
+    /// the first ones.
+    pub fn spawn_target_prefetch(
+        &self,
+        mut backends: Vec<(String, String)>,
+        max_concurrent: usize,
+    ) -> JoinHandle<()> {
+        let capacity = self.target_cache.capacity();
+        if capacity > 0 && backends.len() > capacity {
+            log_debug(&format!(
+                "Prefetching only the first {} of {} targets",
+                capacity,
+                backends.len()
+            ));
+            backends.truncate(capacity);
+        }
+        let service = self.clone();
+        std::thread::spawn(move || {
+            let rt = tokio::runtime::Builder::new_current_thread()
+                .enable_all()
+                .build()
+                .unwrap();
+            rt.block_on(service.prefetch_targets(backends, max_concurrent));
+        })
+    }
+
+    async fn prefetch_targets(&self, backends: Vec<(String, String)>, max_concurrent: usize) {
+        let start = Instant::now();
+        let failures: Vec<(&str, ServiceError)> = futures::stream::iter(&backends)
+            .map(|(name, crn)| async move {
+                cached_target_data(self, name, crn)
+                    .await
+                    .err()
+                    .map(|e| (name.as_str(), e))
+            })
+            .buffer_unordered(max_concurrent.max(1))
+            .filter_map(|x| async move { x })
+            .collect()
+            .await;
+        for (name, e) in failures {
+            log_warn(&format!("Target prefetch failed for {}: {}", name, e));
+        }
+        self.record_timing(|t| t.target_prefetch = start.elapsed().as_secs_f64());
+    }
+
+    /// Keep at most `capacity` built targets in memory, or any number if 0.
+    pub fn limit_target_cache(&self, capacity: usize) {
+        self.target_cache.set_capacity(capacity);
+    }
+
+    /// Wait for any background backend listing and take its result.
+    fn take_prefetched_backends(&self) -> Option<BackendListing> {
+        let handle = self.backend_prefetch.lock().unwrap().take()?;
+        handle.join().ok().flatten()
+    }
+
+    /// Get the instances this service submits through, discovering them if needed.
+    ///
+    /// If the account configuration pins an instance CRN, only that instance is looked up
+    /// rather than searching every quantum-computing resource on the account.
+    pub async fn instances(&self) -> Result<&[Instance], ServiceError> {
+        if let Some(instances) = self.instances.get() {
+            return Ok(instances);
         }
+        let start = Instant::now();
+        let instances = match &self.account.config.instance {
+            Some(crn) => vec![lookup_instance(&self.account, crn).await?],
+            None => list_instances(&self.account).await?,
+        };
+        self.record_timing(|t| t.instance_discovery = start.elapsed().as_secs_f64());
+        Ok(self.instances.get_or_init(|| instances).as_slice())
     }
 }
 
@@ -285,6 +745,7 @@ pub struct Account {
     pub config: AccountEntry,
     token: TokenResponse,
     iam_config: Configuration,
+    search_config: SearchConfiguration,
 }
 
 impl Account {
@@ -303,18 +764,71 @@ pub async fn get_account_from_config(
     filename: Option<&str>,
     name: Option<&str>,
 ) -> Result<Account, ServiceError> {
-    let config = get_account_config(filename, name);
+    authenticate(get_account_config(filename, name)).await
+}
+
+async fn authenticate(config: AccountEntry) -> Result<Account, ServiceError> {
     let iam_config = Configuration {
         base_path: "https://iam.cloud.ibm.com".to_owned(),
         user_agent: Some("qiskit-ibm-runtime-rs/0.0.1".to_owned()),
+        // Shared by every API configuration built from this account so the TLS setup of the
+        // HTTP client is only paid once.
         client: reqwest::Client::new(),
         basic_auth: None,
         oauth_access_token: None,
         bearer_access_token: None,
         api_key: None,
     };
+    let response = request_token(&iam_config, &config).await?;
+    let search_config = search_config(&iam_config, &response);
+    Ok(Account {
+        config,
+        token: response,
+        iam_config,
+        search_config,
+    })
+}
+
+/// Bring up a [Service], recording how long each startup phase takes.
+///
+/// Only the configuration parse and IAM token exchange happen here. Instance discovery and
+/// backend listing run on first use or, with `prefetch_backends`, on a background thread
+/// that overlaps them with whatever the caller does next.
+pub async fn bootstrap_service(
+    filename: Option<&str>,
+    name: Option<&str>,
+    prefetch_backends: bool,
+    prefetch_targets: bool,
+    discovery_cache_ttl: Option<Duration>,
+) -> Result<Service, ServiceError> {
+    let start = Instant::now();
+    let config = get_account_config(filename, name);
+    let config_time = start.elapsed().as_secs_f64();
+    let token_start = Instant::now();
+    let account = authenticate(config).await?;
+    let token_time = token_start.elapsed().as_secs_f64();
+    let mut service = Service::new_lazy(account);
+    if let Some(ttl) = discovery_cache_ttl {
+        service.enable_discovery_cache(ttl);
+    }
+    if prefetch_backends || prefetch_targets {
+        service.spawn_prefetch(prefetch_targets);
+    }
+    service.record_timing(|t| {
+        t.config = config_time;
+        t.iam_token = token_time;
+        t.total = start.elapsed().as_secs_f64();
+    });
+    Ok(service)
+}
+
+/// Exchange the API key of an account for a new IAM access token.
+async fn request_token(
+    iam_config: &Configuration,
+    config: &AccountEntry,
+) -> Result<TokenResponse, ServiceError> {
     let response = get_token_api_key(
-        &iam_config,
+        iam_config,
         "urn:ibm:params:oauth:grant-type:apikey",
         config.token.as_str(),
         None,
@@ -324,292 +838,2076 @@ pub async fn get_account_from_config(
         "get_account_from_config response: {:?}",
         &response
     ));
-    Ok(Account {
-        config,
-        token: response,
-        iam_config,
-    })
+    Ok(response)
 }
 
-pub async fn list_instances(account: &Account) -> Result<Vec<Instance>, ServiceError> {
+fn quantum_api_key(access_token: &str) -> ibm_quantum_platform_api::apis::configuration::ApiKey {
+    ibm_quantum_platform_api::apis::configuration::ApiKey {
+        key: access_token.to_string(),
+        prefix: Some("Bearer".to_string()),
+    }
+}
+
+fn search_config(iam_config: &Configuration, token: &TokenResponse) -> SearchConfiguration {
     let mut config = SearchConfiguration::default();
+    config.client = iam_config.client.clone();
     config.user_agent = Some("qiskit-ibm-runtime-rs/0.0.1".to_string());
     config.api_key = Some(ibmcloud_global_search_api::apis::configuration::ApiKey {
-        key: account.get_access_token().unwrap().to_string(),
+        key: token.access_token.clone().unwrap(),
         prefix: Some("Bearer".to_string()),
     });
-    let body = ibmcloud_global_search_api::models::SearchRequest::FirstCall(Box::new(
-        ibmcloud_global_search_api::models::FirstCall {
-            query: "service_name:quantum-computing".to_string(),
-            fields: Some(
-                ["crn", "service_plan_unique_id", "name", "doc"]
-                    .into_iter()
-                    .map(|x| x.to_string())
-                    .collect(),
-            ),
-        },
-    ));
-    let resp = search(
-        &config,
-        body,
-        None,      // x_request_id
-        None,      // x_correlation_id
-        None,      // account_id
-        Some(100), // limit
-        None,      // timeout
-        None,      // sort
-        None,      // is_deleted
-        None,      // is_reclaimed
-        None,      // is_public
-        None,      // impersonate_user
-        None,      // can_tag
-        None,      // is_project_resource
-    )
-    .await?;
-    log_debug(&format!("list_instances response: {:?}", &resp));
-    let items = resp.items;
-    Ok(items
-        .into_iter()
-        .filter_map(|x| {
-            if let Some(doc) = x.doc {
-                // Filter for only instances with backend allocations
-                if doc.contains_key("extensions") {
-                    return Some(Instance {
-                        crn: CString::new(x.crn).unwrap(),
-                        name: CString::new(x.name.unwrap()).unwrap(),
-                    });
-                }
-            }
-            None
-        })
-        .collect())
+    config
 }
 
-pub async fn get_backend(service: &Service, backend: &Backend) -> crate::qiskit_target::Target {
-    let name = backend.response.name.clone();
-    let crn = backend.instance.crn.to_str().unwrap();
+/// How many backends a target prefetch fetches at once unless told otherwise.
+pub const DEFAULT_PREFETCH_CONCURRENCY: usize = 8;
 
-    let backend_configuration = get_backend_configuration(
-        &service.quantum_config,
-        name.as_str(),
-        crn,
-        Some("2025-06-01"),
-    )
-    .await
-    .unwrap();
-    let backend_properties = get_backend_properties(
-        &service.quantum_config,
-        name.as_str(),
-        crn,
-        Some("2025-06-01"),
-        None,
-    )
-    .await
-    .unwrap();
-    let num_qubits = backend_configuration["n_qubits"]
-        .as_u64()
-        .unwrap()
-        .try_into()
-        .unwrap();
-    let mut gate_prop_map: HashMap<String, Vec<(Vec<u32>, Option<f64>, Option<f64>)>> =
-        HashMap::new();
-    for gate in backend_properties["gates"].as_array().unwrap() {
-        let gate_map = gate.as_object().unwrap();
-        let gate_params = gate_map["parameters"].as_array().unwrap();
-        let mut gate_error: Option<f64> = None;
-        let mut gate_duration: Option<f64> = None;
-        for prop in gate_params {
-            let prop = prop.as_object().unwrap();
-            let name = prop["name"].as_str().unwrap();
-            if name == "gate_error" {
-                gate_error = prop["value"].as_f64();
-            } else if name == "gate_length" {
-                let unit = prop["unit"].as_str().unwrap();
-                if unit == "ns" {
-                    gate_duration = prop["value"].as_f64().map(|x| x * 1e-9);
-                } else {
-                    panic!("Non-nanosecond unit for gate duration");
-                }
-            }
-        }
-        let qargs = gate_map["qubits"]
-            .as_array()
-            .unwrap()
-            .iter()
-            .map(|x| x.as_u64().unwrap() as u32)
-            .collect::<Vec<_>>();
-        gate_prop_map
-            .entry(gate_map["gate"].as_str().unwrap().to_string())
-            .and_modify(|props| {
-                props.push((qargs.clone(), gate_duration, gate_error));
-            })
-            .or_insert(vec![(qargs, gate_duration, gate_error)]);
-    }
-
-    let mut target = crate::qiskit_target::Target::new(num_qubits);
-    for (gate, props) in gate_prop_map {
-        let gate = if gate == "x" {
-            crate::qiskit_target::ISAGate::X
-        } else if gate == "sx" {
-            crate::qiskit_target::ISAGate::SX
-        } else if gate == "cz" {
-            crate::qiskit_target::ISAGate::CZ
-        } else if gate == "ecr" {
-            crate::qiskit_target::ISAGate::ECR
-        } else if gate == "rz" {
-            crate::qiskit_target::ISAGate::RZ
-        } else if gate == "rx" {
-            crate::qiskit_target::ISAGate::RX
-        } else if gate == "id" {
-            crate::qiskit_target::ISAGate::I
-        } else if gate == "cx" {
-            crate::qiskit_target::ISAGate::CX
-        } else if gate == "rzz" {
-            // TODO: Add RZZ support when we have angle wrapping in
-            // Qiskit's target and C transpiler.
-            //            crate::qiskit_target::ISAGate::RZZ
-            continue;
-        } else if gate == "reset" {
-            target.add_reset(
-                props
-                    .into_iter()
-                    .map(|(qubits, dur, err)| (qubits[0], [dur, err])),
-            );
-            continue;
-        } else {
-            panic!("What is a {gate}?");
-        };
-        target.add_gate(
-            gate,
-            props
+/// The number of resources requested per Global Search page.
+const SEARCH_PAGE_SIZE: i32 = 100;
+
+/// Run a Global Search query page by page, following the search cursor until the results run
+/// out. Each page is only requested once the previous one has been consumed.
+fn search_pages(
+    account: &Account,
+    query: String,
+    page_size: i32,
+) -> impl Stream<Item = Result<Vec<ResultItem>, ServiceError>> + '_ {
+    let first = SearchRequest::FirstCall(Box::new(FirstCall {
+        query,
+        fields: Some(
+            ["crn", "service_plan_unique_id", "name", "doc"]
                 .into_iter()
-                .map(|(qubits, dur, err)| (qubits, [dur, err])),
-        );
-    }
-    let measure_props = backend_properties["qubits"]
-        .as_array()
-        .unwrap()
-        .into_iter()
-        .enumerate()
-        .map(|(idx, props)| {
-            let mut error = None;
-            let mut duration = None;
-            for prop in props.as_array().unwrap() {
-                let prop = prop.as_object().unwrap();
-                let name = prop["name"].as_str().unwrap();
-                if name == "readout_error" {
-                    error = prop["value"].as_f64();
-                } else if name == "readout_length" {
-                    duration = prop["value"].as_f64();
-                }
-            }
-            (idx as u32, [duration, error])
-        });
-    target.add_measure(measure_props);
-    target
+                .map(|x| x.to_string())
+                .collect(),
+        ),
+    }));
+    futures::stream::try_unfold(Some(first), move |request| async move {
+        let Some(request) = request else {
+            return Ok(None);
+        };
+        let resp = search(
+            &account.search_config,
+            request,
+            None,            // x_request_id
+            None,            // x_correlation_id
+            None,            // account_id
+            Some(page_size), // limit
+            None,            // timeout
+            None,            // sort
+            None,            // is_deleted
+            None,            // is_reclaimed
+            None,            // is_public
+            None,            // impersonate_user
+            None,            // can_tag
+            None,            // is_project_resource
+        )
+        .await?;
+        log_debug(&format!("search_instances response: {:?}", &resp));
+        // An empty page, or one without a cursor, ends the result set.
+        if resp.items.is_empty() {
+            return Ok(None);
+        }
+        let next = resp
+            .search_cursor
+            .map(|search_cursor| SearchRequest::NextCall(NextCall { search_cursor }));
+        Ok(Some((resp.items, next)))
+    })
 }
 
-pub async fn submit_sampler_job(
-    service: &Service,
-    backend: &Backend,
-    circuit: &crate::qiskit_circuit::Circuit,
-    shots: Option<i32>,
-    runtime: Option<String>,
-    tags: Option<Vec<String>>,
-) -> Result<Job, ServiceError> {
-    let crn = backend.instance.crn.to_str().unwrap();
-    let job_payload = crate::generate_job_params::create_sampler_job_payload(
-        circuit,
-        backend.response.name.clone(),
-        shots,
-        runtime,
-        tags,
-    );
-    let file = File::create("/tmp/test.json").unwrap();
-    serde_json::to_writer_pretty(file, &job_payload).unwrap();
-    let res = create_job(
-        &service.quantum_config,
-        crn,
-        Some("2025-06-01"),
-        None,
-        Some(CreateJobRequest::CreateJobRequestOneOf(Box::new(
-            job_payload,
-        ))),
+/// The quantum-computing instances of the account, one Global Search page at a time.
+fn instance_pages(
+    account: &Account,
+) -> impl Stream<Item = Result<Vec<Instance>, ServiceError>> + '_ {
+    search_pages(
+        account,
+        "service_name:quantum-computing".to_string(),
+        SEARCH_PAGE_SIZE,
     )
-    .await?;
-    log_debug(&format!("submit_sampler_job response: {:?}", res));
-    Ok(Job {
-        instance: backend.instance.clone(),
-        response: res,
+    .map_ok(|items| {
+        items
+            .into_iter()
+            .filter_map(|x| {
+                if let Some(doc) = x.doc {
+                    // Filter for only instances with backend allocations
+                    if doc.contains_key("extensions") {
+                        return Some(Instance {
+                            crn: CString::new(x.crn).unwrap(),
+                            name: CString::new(x.name.unwrap()).unwrap(),
+                        });
+                    }
+                }
+                None
+            })
+            .collect()
     })
 }
 
-pub async fn get_job_details(service: &Service, job: &Job) -> Result<JobDetails, ServiceError> {
-    let crn = job.instance.crn.to_str().unwrap();
-    let details = get_job_details_jid(
-        &service.quantum_config,
-        crn,
-        &job.response.id,
-        Some("2025-06-01"),
-        None,
-    )
-    .await?;
-    log_debug(&format!("get_job_details response: {:?}", details));
-    Ok(JobDetails(details))
+pub async fn list_instances(account: &Account) -> Result<Vec<Instance>, ServiceError> {
+    instance_pages(account).try_concat().await
 }
 
-#[derive(Debug)]
-pub struct Samples(pub Vec<String>);
+/// Build the [Instance] for a known CRN, querying Global Search for that single resource
+/// only to resolve its display name.
+pub async fn lookup_instance(account: &Account, crn: &str) -> Result<Instance, ServiceError> {
+    let mut pages = std::pin::pin!(search_pages(account, format!("crn:\"{}\"", crn), 1));
+    let items = pages.try_next().await?.unwrap_or_default();
+    let name = match items.into_iter().find(|x| x.crn == crn) {
+        Some(item) => item.name.unwrap_or_else(|| crn.to_string()),
+        None => {
+            log_warn(&format!(
+                "Configured instance was not found by Global Search: {}",
+                crn
+            ));
+            crn.to_string()
+        }
+    };
+    Ok(Instance {
+        crn: CString::new(crn).unwrap(),
+        name: CString::new(name).unwrap(),
+    })
+}
 
-pub async fn get_job_results(service: &Service, job: &Job) -> Result<Samples, ServiceError> {
-    let crn = job.instance.crn.to_str().unwrap();
-    let details = get_job_results_jid(
-        &service.quantum_config,
-        crn,
-        &job.response.id,
-        Some("2025-06-01"),
-    )
-    .await?;
-    log_debug(&format!("get_job_result response: {:?}", details));
-    let res = Ok(Samples(
-        details
-            .results
-            .iter()
-            .flat_map(|x| x.data["meas"].samples.iter())
-            .cloned()
-            .collect(),
-    ));
-    res
+pub async fn get_backend(service: &Service, backend: &Backend) -> Result<Target, ServiceError> {
+    let name = backend.response.name.as_str();
+    let (target, _) = cached_target(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    Ok(target)
 }
 
-pub async fn get_job_status(service: &Service, job: &Job) -> Result<JobStatus, ServiceError> {
-    let details = get_job_details(service, job).await?;
-    Ok(details.status())
+/// A target built for a backend, owned together with the data it was last brought up to date
+/// with, so [refresh_target] can update it in place with only what changed.
+pub struct BackendTarget {
+    target: Target,
+    backend: Backend,
+    snapshot: Arc<TargetData>,
 }
 
-pub async fn get_backends(service: &Service) -> Result<BackendSearchResults, ServiceError> {
-    let mut backends = Vec::new();
-    let mut ptrs = Vec::new();
-    for instance in &service.instances {
-        let crn = instance.crn.to_str().unwrap();
-        let Ok(resp) = list_backends(&service.quantum_config, Some("2025-06-01"), crn).await else {
-            let instance_name = instance.name.to_str().unwrap();
-            log_warn(&format!(
-                "Failed to list backends for instance: {} ({})",
-                instance_name, crn
-            ));
-            continue;
-        };
-        log_debug(&format!("get_backends response: {:?}", &resp));
-        for backend in resp.devices.into_iter().flatten() {
-            let backend = Box::new(Backend {
-                name: CString::new(backend.name.as_str()).unwrap(),
-                instance: instance.clone(),
-                response: backend,
+impl BackendTarget {
+    pub fn target(&self) -> &Target {
+        &self.target
+    }
+}
+
+/// Get the target of a backend as a [BackendTarget], from the same cache as [get_backend].
+pub async fn get_backend_target(
+    service: &Service,
+    backend: &Backend,
+) -> Result<BackendTarget, ServiceError> {
+    let name = backend.response.name.as_str();
+    let (target, snapshot) =
+        cached_target(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    Ok(BackendTarget {
+        target,
+        backend: backend.clone(),
+        snapshot,
+    })
+}
+
+/// Bring a target up to date with its backend's latest calibration, updating only the
+/// properties that changed.
+pub async fn refresh_target(
+    service: &Service,
+    target: &mut BackendTarget,
+) -> Result<TargetRefresh, ServiceError> {
+    let backend = &target.backend;
+    let name = backend.response.name.as_str();
+    let latest = cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    let (refresh, applied) = latest.update_target(&target.snapshot, &mut target.target);
+    target.snapshot = if refresh.not_applied == 0 {
+        latest
+    } else {
+        Arc::new(applied)
+    };
+    Ok(refresh)
+}
+
+/// The weighted coupling map of a backend. It shares the cached data of the backend's target,
+/// and the map is built once per calibration.
+pub struct CouplingGraph(Arc<TargetData>);
+
+impl CouplingGraph {
+    pub fn num_qubits(&self) -> u32 {
+        self.0.num_qubits
+    }
+
+    pub fn map(&self) -> &WeightedCouplingMap {
+        self.0.coupling_map()
+    }
+}
+
+pub async fn get_coupling_graph(
+    service: &Service,
+    backend: &Backend,
+) -> Result<CouplingGraph, ServiceError> {
+    let name = backend.response.name.as_str();
+    let data = cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    data.coupling_map();
+    Ok(CouplingGraph(data))
+}
+
+/// Start a pipeline that transpiles circuits for a backend and submits them as sampler jobs,
+/// see [crate::pipeline].
+pub async fn start_pipeline(
+    service: &Service,
+    backend: &Backend,
+    options: &PipelineOptions,
+) -> Result<Pipeline, ServiceError> {
+    let start = Instant::now();
+    let name = backend.response.name.as_str();
+    let (target, data) =
+        cached_target(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    Ok(Pipeline::start(
+        service,
+        backend,
+        target,
+        data,
+        start.elapsed(),
+        options,
+    ))
+}
+
+/// Transpile `circuit` for a backend, reusing the result of an earlier transpilation of the
+/// same circuit with the same options against the same calibration, see [TranspileCache].
+pub async fn transpile_cached(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    options: &QkTranspileOptions,
+) -> Result<crate::qiskit_circuit::Circuit, ServiceError> {
+    let name = backend.response.name.as_str();
+    let (target, data) =
+        cached_target(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    // A negative seed asks for a differently seeded transpilation on every call.
+    let calibration = data.calibration.as_deref().filter(|_| options.seed >= 0);
+    let key = calibration.map(|calibration| {
+        TranspileCache::key(
+            circuit.num_qubits(),
+            circuit.num_clbits(),
+            circuit.get_circuit_instructions(),
+            name,
+            calibration,
+            options,
+        )
+    });
+    if let Some(hit) = key.and_then(|key| service.transpile_cache.get(name, &key)) {
+        return Ok(hit);
+    }
+    let transpiled = crate::transpile::transpile(circuit.0, &target, options)
+        .map_err(|(_, message)| ServiceError {
+            code: ExitCode::BadArgumentError,
+            message,
+        })?
+        .into_circuit();
+    if let Some(key) = key {
+        service.transpile_cache.insert(name, &key, &transpiled);
+    }
+    Ok(transpiled)
+}
+
+/// Transpile `circuit` for a backend with several seeds in parallel and keep the best result,
+/// see [crate::transpile]. Once the target is available, the outcome of every trial is
+/// returned, along with the best result or why every trial failed.
+pub async fn transpile_best_of(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    num_trials: u32,
+    options: &QkTranspileOptions,
+    selection: TranspileSelection,
+) -> Result<(Result<QkTranspileResult, ServiceError>, Vec<TranspileTrial>), ServiceError> {
+    let name = backend.response.name.as_str();
+    let (target, data) =
+        cached_target(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    let (best, trials) = crate::transpile::transpile_best_of(
+        circuit, &target, &data, num_trials, options, selection,
+    );
+    let best = best.map_err(|message| ServiceError {
+        code: ExitCode::BadArgumentError,
+        message,
+    });
+    Ok((best, trials))
+}
+
+/// Check that `circuit` only uses instructions the backend supports, on qubits it supports them
+/// on, see [crate::isa].
+pub async fn check_isa(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+) -> Result<IsaReport, ServiceError> {
+    let name = backend.response.name.as_str();
+    let data = cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    Ok(validate_isa(circuit.get_circuit_instructions(), &data))
+}
+
+/// Estimate the QPU time of `shots` shots of `circuit`, an ISA circuit for the backend, with
+/// `rep_delay` seconds between shots, from the durations the backend reports.
+pub async fn estimate_backend_qpu_time(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    shots: Option<i32>,
+    rep_delay: Option<f64>,
+) -> Result<QpuTimeEstimate, ServiceError> {
+    let name = backend.response.name.as_str();
+    let data = cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    Ok(estimate_qpu_time(
+        circuit.num_qubits(),
+        circuit.get_circuit_instructions(),
+        &data,
+        shots.unwrap_or(DEFAULT_SHOTS),
+        rep_delay.unwrap_or(REP_DELAY_SECONDS),
+    ))
+}
+
+/// Estimate the probability that `circuit`, an ISA circuit for the backend, runs without error,
+/// see [crate::fidelity].
+pub async fn estimate_success_probability(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+) -> Result<f64, ServiceError> {
+    Ok(estimate_success_probabilities(service, &[backend], circuit).await?[0])
+}
+
+/// Estimate the probability that `circuit` runs without error on each of `backends`.
+///
+/// The backends' properties are fetched concurrently, the circuit is read once, and it is
+/// scored against the backends in parallel.
+pub async fn estimate_success_probabilities(
+    service: &Service,
+    backends: &[&Backend],
+    circuit: &crate::qiskit_circuit::Circuit,
+) -> Result<Vec<f64>, ServiceError> {
+    let data = futures::future::try_join_all(backends.iter().map(|backend| async {
+        let name = backend.response.name.as_str();
+        cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await
+    }))
+    .await?;
+    let operations = CircuitOperations::new(circuit.get_circuit_instructions());
+    let data: Vec<&TargetData> = data.iter().map(|x| x.as_ref()).collect();
+    Ok(operations.success_probabilities(&data))
+}
+
+/// Find a connected region of `k` qubits of a backend with low errors, see
+/// [crate::qubit_subset], and build the target of just that region.
+///
+/// Returns the target with the physical qubit of each of its qubits.
+pub async fn get_best_subset(
+    service: &Service,
+    backend: &Backend,
+    k: u32,
+    objective: SubsetObjective,
+) -> Result<(Target, Vec<u32>), ServiceError> {
+    let name = backend.response.name.as_str();
+    let data = cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    let qubits = best_subset(&data, k, objective).map_err(|message| ServiceError {
+        code: ExitCode::BadArgumentError,
+        message,
+    })?;
+    Ok((data.restrict(&qubits).build(), qubits))
+}
+
+/// Get a copy of the target of a backend from the target cache, with the data it was built
+/// from. The target is fetched and built if the cache misses or the backend has been
+/// calibrated since it was cached.
+async fn cached_target(
+    service: &Service,
+    name: &str,
+    crn: &str,
+) -> Result<(Target, Arc<TargetData>), ServiceError> {
+    cached_entry(service, name, crn, Target::copy).await
+}
+
+/// Like [cached_target], for callers that only need the data, without copying the target.
+async fn cached_target_data(
+    service: &Service,
+    name: &str,
+    crn: &str,
+) -> Result<Arc<TargetData>, ServiceError> {
+    Ok(cached_entry(service, name, crn, |_| ()).await?.1)
+}
+
+async fn cached_entry<T>(
+    service: &Service,
+    name: &str,
+    crn: &str,
+    take: impl Fn(&Target) -> T,
+) -> Result<(T, Arc<TargetData>), ServiceError> {
+    let cache = &service.target_cache;
+    let lock = cache.fetch_lock(name);
+    let _fetching = lock.lock().await;
+    let Some(hit) = cache.get(name, &take) else {
+        return Ok(cache.insert(name, fetch_target_data(service, name, crn).await?, take));
+    };
+    if hit.fresh {
+        return Ok((hit.target, hit.data));
+    }
+    let properties = fetch_properties(service, name, crn).await?;
+    if properties.calibration == hit.data.calibration {
+        cache.mark_checked(name);
+        return Ok((hit.target, hit.data));
+    }
+    log_debug(&format!("{} was calibrated, rebuilding its target", name));
+    let configuration = fetch_configuration(service, name, crn).await?;
+    Ok(cache.insert(name, properties.with_configuration(&configuration), take))
+}
+
+fn invalid_backend_data(name: &str, message: String) -> ServiceError {
+    ServiceError {
+        code: ExitCode::QuantumAPIUnhandledError,
+        message: format!("Cannot build the target of {}: {}", name, message),
+    }
+}
+
+async fn fetch_configuration(
+    service: &Service,
+    name: &str,
+    crn: &str,
+) -> Result<BackendConfiguration, ServiceError> {
+    let mut body =
+        get_backend_configuration_bytes(&service.quantum_config, name, crn, Some("2025-06-01"))
+            .await?;
+    BackendConfiguration::parse(&mut body).map_err(|e| invalid_backend_data(name, e))
+}
+
+async fn fetch_properties(
+    service: &Service,
+    name: &str,
+    crn: &str,
+) -> Result<TargetData, ServiceError> {
+    let mut body =
+        get_backend_properties_bytes(&service.quantum_config, name, crn, Some("2025-06-01"), None)
+            .await?;
+    TargetData::parse_properties(&mut body).map_err(|e| invalid_backend_data(name, e))
+}
+
+/// Fetch the configuration and properties of a backend.
+///
+/// Both documents are requested at once, and each is parsed as soon as it arrives.
+async fn fetch_target_data(
+    service: &Service,
+    name: &str,
+    crn: &str,
+) -> Result<TargetData, ServiceError> {
+    let (configuration, properties) = futures::try_join!(
+        fetch_configuration(service, name, crn),
+        fetch_properties(service, name, crn)
+    )?;
+    Ok(properties.with_configuration(&configuration))
+}
+
+pub async fn submit_sampler_job(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    shots: Option<i32>,
+    runtime: Option<String>,
+    tags: Option<Vec<String>>,
+) -> Result<Job, ServiceError> {
+    if service.validate_isa {
+        let report = check_isa(service, backend, circuit).await?;
+        if !report.is_valid() {
+            return Err(ServiceError {
+                code: ExitCode::BadArgumentError,
+                message: format!(
+                    "Not an ISA circuit for {}: {}",
+                    backend.response.name, report
+                ),
+            });
+        }
+    }
+    let job = encode_sampler_job(backend, circuit, shots, runtime, tags);
+    submit_encoded_job(service, backend, job).await
+}
+
+/// What submitting a sampler job would involve, from [dry_run_sampler_job].
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default)]
+pub struct SamplerDryRun {
+    pub qpu_time: QpuTimeEstimate,
+    /// The size of the job request that would be posted, in bytes.
+    pub payload_bytes: usize,
+}
+
+/// Build the request [submit_sampler_job] would post, without posting it, and report its size
+/// and the job's estimated QPU time. The circuit is always checked against the backend's ISA.
+pub async fn dry_run_sampler_job(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    shots: Option<i32>,
+    runtime: Option<String>,
+) -> Result<SamplerDryRun, ServiceError> {
+    let name = backend.response.name.as_str();
+    let data = cached_target_data(service, name, backend.instance.crn.to_str().unwrap()).await?;
+    let report = validate_isa(circuit.get_circuit_instructions(), &data);
+    if !report.is_valid() {
+        return Err(ServiceError {
+            code: ExitCode::BadArgumentError,
+            message: format!("Not an ISA circuit for {}: {}", name, report),
+        });
+    }
+    let job = encode_sampler_job(backend, circuit, shots, runtime, None);
+    let payload = serde_json::to_vec(&CreateJobRequest::CreateJobRequestOneOf(Box::new(
+        job.payload,
+    )))
+    .map_err(|e| ServiceError {
+        code: ExitCode::BadArgumentError,
+        message: format!("Failed to serialize the job request: {}", e),
+    })?;
+    Ok(SamplerDryRun {
+        qpu_time: estimate_qpu_time(
+            circuit.num_qubits(),
+            circuit.get_circuit_instructions(),
+            &data,
+            shots.unwrap_or(DEFAULT_SHOTS),
+            REP_DELAY_SECONDS,
+        ),
+        payload_bytes: payload.len(),
+    })
+}
+
+/// A sampler job ready to be submitted, which no longer needs its circuit.
+pub(crate) struct EncodedJob {
+    payload: ibm_quantum_platform_api::models::CreateJobRequestOneOf,
+    submission: SubmissionRecord,
+}
+
+/// Encode the request to run `circuit` on `backend`, as QPY compressed into the payload.
+pub(crate) fn encode_sampler_job(
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    shots: Option<i32>,
+    runtime: Option<String>,
+    tags: Option<Vec<String>>,
+) -> EncodedJob {
+    EncodedJob {
+        payload: crate::generate_job_params::create_sampler_job_payload(
+            circuit,
+            backend.response.name.clone(),
+            shots,
+            runtime,
+            tags,
+        ),
+        submission: SubmissionRecord {
+            queue_length: backend.queue_length(),
+            estimated_qpu_seconds: estimate_qpu_seconds(circuit, shots.unwrap_or(DEFAULT_SHOTS)),
+        },
+    }
+}
+
+pub(crate) async fn submit_encoded_job(
+    service: &Service,
+    backend: &Backend,
+    job: EncodedJob,
+) -> Result<Job, ServiceError> {
+    let instance = submit_instance(service, backend).await;
+    let crn = instance.crn.to_str().unwrap();
+    let res = create_job(
+        &service.quantum_config,
+        crn,
+        Some("2025-06-01"),
+        None,
+        Some(CreateJobRequest::CreateJobRequestOneOf(Box::new(
+            job.payload,
+        ))),
+    )
+    .await?;
+    log_debug(&format!("submit_sampler_job response: {:?}", res));
+    // Count the new job against a cached load, so submissions until it is fetched again are
+    // spread over the instances.
+    let key = (crn.to_string(), backend.response.name.clone());
+    if let Some((_, load)) = service.instance_loads.lock().unwrap().get_mut(&key) {
+        load.active_workloads += 1;
+    }
+    Ok(Job {
+        instance,
+        response: res,
+        backend: backend.response.name.clone(),
+        submission: job.submission,
+    })
+}
+
+pub async fn get_job_details(service: &Service, job: &Job) -> Result<JobDetails, ServiceError> {
+    let crn = job.instance.crn.to_str().unwrap();
+    let details = get_job_details_jid(
+        &service.quantum_config,
+        crn,
+        &job.response.id,
+        Some("2025-06-01"),
+        None,
+    )
+    .await?;
+    log_debug(&format!("get_job_details response: {:?}", details));
+    Ok(JobDetails(details))
+}
+
+#[derive(Debug)]
+pub struct Samples(pub Vec<String>);
+
+pub async fn get_job_results(service: &Service, job: &Job) -> Result<Samples, ServiceError> {
+    let crn = job.instance.crn.to_str().unwrap();
+    let predictor = service.predictor();
+    // The job has finished, so its metrics now show the actual queue wait and QPU time. They
+    // are fetched alongside the results, unless the job was already learned from.
+    let learn = async {
+        if predictor.has_learned(&job.response.id) {
+            return;
+        }
+        match fetch_job_metrics(service, job).await {
+            Ok(metrics) => {
+                predictor.observe(&job.response.id, &job.backend, &job.submission, &metrics)
+            }
+            Err(e) => log_warn(&format!(
+                "Failed to fetch metrics of job {}: {}",
+                job.response.id, e
+            )),
+        }
+    };
+    let (details, ()) = tokio::join!(
+        get_job_results_jid(
+            &service.quantum_config,
+            crn,
+            &job.response.id,
+            Some("2025-06-01"),
+        ),
+        learn
+    );
+    let details = details?;
+    log_debug(&format!("get_job_result response: {:?}", details));
+    let res = Ok(Samples(
+        details
+            .results
+            .iter()
+            .flat_map(|x| x.data["meas"].samples.iter())
+            .cloned()
+            .collect(),
+    ));
+    res
+}
+
+pub async fn get_job_status(service: &Service, job: &Job) -> Result<JobStatus, ServiceError> {
+    let details = get_job_details(service, job).await?;
+    Ok(details.status())
+}
+
+async fn fetch_job_metrics(
+    service: &Service,
+    job: &Job,
+) -> Result<models::JobMetrics, ServiceError> {
+    let metrics = get_job_metrics_jid(
+        &service.quantum_config,
+        job.instance.crn.to_str().unwrap(),
+        &job.response.id,
+        Some("2025-06-01"),
+    )
+    .await?;
+    log_debug(&format!("get_job_metrics response: {:?}", metrics));
+    Ok(metrics)
+}
+
+/// Predict how long a job submitted to `backend` now would take to return results.
+///
+/// This does not make network requests; it uses the backend's last known queue length.
+pub fn predict_completion(
+    service: &Service,
+    backend: &Backend,
+    circuit: &crate::qiskit_circuit::Circuit,
+    shots: Option<i32>,
+) -> CompletionPrediction {
+    service.predictor().predict(
+        &backend.response.name,
+        backend.queue_length(),
+        estimate_qpu_seconds(circuit, shots.unwrap_or(DEFAULT_SHOTS)),
+    )
+}
+
+/// Predict the remaining time until a submitted job returns results, from its current metrics.
+pub async fn predict_job_completion(
+    service: &Service,
+    job: &Job,
+) -> Result<CompletionPrediction, ServiceError> {
+    let metrics = fetch_job_metrics(service, job).await?;
+    let predictor = service.predictor();
+    predictor.observe(&job.response.id, &job.backend, &job.submission, &metrics);
+    Ok(predictor.predict_job(&job.backend, &job.submission, &metrics))
+}
+
+/// The most per-instance or per-backend requests in flight at once, so accounts with many
+/// instances or backends don't open a connection for each.
+const MAX_CONCURRENT_REQUESTS: usize = 8;
+
+/// How long the load of an instance is reused when choosing between instances, so searches and
+/// submissions in quick succession don't fetch it again.
+const INSTANCE_LOAD_TTL: Duration = Duration::from_secs(30);
+
+/// List the backends of every instance of the service, skipping instances whose listing fails.
+async fn list_all_backends(service: &Service) -> Result<BackendListing, ServiceError> {
+    let start = Instant::now();
+    let listing = if service.instances.get().is_some() {
+        list_instance_backends(service).await?
+    } else if let Some(crn) = service.account.config.instance.as_deref() {
+        // The pinned CRN is all the listing needs, so overlap it with the name lookup.
+        let (instances, resp) = tokio::join!(
+            service.instances(),
+            list_backends(&service.quantum_config, Some("2025-06-01"), crn)
+        );
+        let mut listing = Vec::new();
+        extend_listing(&mut listing, &instances?[0], resp);
+        listing
+    } else {
+        discover_and_list_backends(service).await?
+    };
+    service.record_timing(|t| t.backend_listing = start.elapsed().as_secs_f64());
+    service.store_cached_backends(service.instances().await?, &listing);
+    Ok(listing)
+}
+
+/// Add the backends of one instance's listing response to `listing`, or warn and skip the
+/// instance if its listing failed.
+fn extend_listing<E>(
+    listing: &mut BackendListing,
+    instance: &Instance,
+    resp: Result<models::BackendsResponseV2, E>,
+) {
+    let Ok(resp) = resp else {
+        let instance_name = instance.name.to_str().unwrap();
+        let crn = instance.crn.to_str().unwrap();
+        log_warn(&format!(
+            "Failed to list backends for instance: {} ({})",
+            instance_name, crn
+        ));
+        return;
+    };
+    log_debug(&format!("get_backends response: {:?}", &resp));
+    listing.extend(
+        resp.devices
+            .into_iter()
+            .flatten()
+            .map(|backend| (instance.clone(), backend)),
+    );
+}
+
+/// List the backends of the already resolved instances.
+async fn list_instance_backends(service: &Service) -> Result<BackendListing, ServiceError> {
+    let instances = service.instances().await?;
+    // Listing is one request per instance, so issue them concurrently. `buffered` keeps the
+    // responses in instance order, which keeps the search results deterministic.
+    let responses: Vec<_> = futures::stream::iter(instances)
+        .map(|instance| {
+            list_backends(
+                &service.quantum_config,
+                Some("2025-06-01"),
+                instance.crn.to_str().unwrap(),
+            )
+        })
+        .buffered(MAX_CONCURRENT_REQUESTS)
+        .collect()
+        .await;
+    let mut listing = Vec::new();
+    for (instance, resp) in instances.iter().zip(responses) {
+        extend_listing(&mut listing, instance, resp);
+    }
+    Ok(listing)
+}
+
+/// Discover the account's instances and list their backends in one pipeline: the instances of
+/// each Global Search page are listed while the following pages are still being fetched.
+async fn discover_and_list_backends(service: &Service) -> Result<BackendListing, ServiceError> {
+    let start = Instant::now();
+    let mut listings = std::pin::pin!(instance_pages(&service.account)
+        .map_ok(|page| futures::stream::iter(page).map(Ok::<_, ServiceError>))
+        .try_flatten()
+        .map_ok(|instance| async move {
+            let resp = list_backends(
+                &service.quantum_config,
+                Some("2025-06-01"),
+                instance.crn.to_str().unwrap(),
+            )
+            .await;
+            Ok((instance, resp))
+        })
+        .try_buffered(MAX_CONCURRENT_REQUESTS));
+    let mut instances = Vec::new();
+    let mut listing = Vec::new();
+    while let Some((instance, resp)) = listings.try_next().await? {
+        extend_listing(&mut listing, &instance, resp);
+        instances.push(instance);
+    }
+    service.record_timing(|t| t.instance_discovery = start.elapsed().as_secs_f64());
+    // A concurrent caller may have resolved the instances meanwhile; either result is current.
+    let _ = service.instances.set(instances);
+    Ok(listing)
+}
+
+/// The backend listing, from the background prefetch or the discovery cache if possible.
+async fn current_listing(service: &Service) -> Result<BackendListing, ServiceError> {
+    match service.take_prefetched_backends() {
+        Some(listing) => Ok(listing),
+        None => match service.cached_backends() {
+            Some(listing) => Ok(listing),
+            None => list_all_backends(service).await,
+        },
+    }
+}
+
+/// Fetch the load of `instance` relevant to running on `backend`.
+async fn fetch_instance_load(
+    service: &Service,
+    instance: &Instance,
+    backend: &str,
+) -> Result<InstanceLoad, ServiceError> {
+    let crn = instance.crn.to_str().unwrap();
+    let active = vec!["pending".to_string(), "in_progress".to_string()];
+    // Only the total count of active workloads is needed, so ask for a single item.
+    let (usage, workloads) = tokio::join!(
+        get_usage(&service.quantum_config, crn, Some("2025-06-01")),
+        find_instance_workloads(
+            &service.quantum_config,
+            crn,
+            Some("2025-06-01"),
+            None,          // user
+            None,          // sort
+            Some(1.),      // limit
+            None,          // previous
+            None,          // next
+            Some(backend), // backend
+            None,          // search
+            Some(active),  // status
+            None,          // mode
+            None,          // created_after
+            None,          // created_before
+            None,          // tags
+        )
+    );
+    let usage = usage?;
+    let workloads = workloads?;
+    log_debug(&format!("get_usage response: {:?}", &usage));
+    Ok(InstanceLoad {
+        candidates: 0,
+        active_workloads: workloads.total_count as u32,
+        usage_consumed_seconds: usage.usage_consumed_seconds,
+        usage_limit_seconds: usage.usage_limit_seconds.unwrap_or(0.),
+        usage_limit_reached: usage.usage_limit_reached.unwrap_or(false),
+    })
+}
+
+/// The load of `instance` for `backend`, reused if it was fetched in the last
+/// [INSTANCE_LOAD_TTL]. Failures are logged and not cached.
+async fn instance_load(
+    service: &Service,
+    instance: &Instance,
+    backend: &str,
+) -> Option<InstanceLoad> {
+    let key = (
+        instance.crn.to_str().unwrap().to_string(),
+        backend.to_string(),
+    );
+    if let Some((fetched, load)) = service.instance_loads.lock().unwrap().get(&key) {
+        if fetched.elapsed() < service.instance_load_ttl {
+            return Some(*load);
+        }
+    }
+    match fetch_instance_load(service, instance, backend).await {
+        Ok(load) => {
+            service
+                .instance_loads
+                .lock()
+                .unwrap()
+                .insert(key, (Instant::now(), load));
+            Some(load)
+        }
+        Err(e) => {
+            log_warn(&format!(
+                "Failed to fetch the load of instance {} for backend {}: {}",
+                instance.name.to_str().unwrap(),
+                backend,
+                e
+            ));
+            None
+        }
+    }
+}
+
+/// The index of the preferred of `loads`. An unknown load is only chosen if no other is known.
+fn least_loaded(loads: &[Option<InstanceLoad>]) -> usize {
+    (0..loads.len())
+        .min_by(|&a, &b| match (&loads[a], &loads[b]) {
+            (Some(x), Some(y)) => x.preference().partial_cmp(&y.preference()).unwrap(),
+            (Some(_), None) => std::cmp::Ordering::Less,
+            (None, Some(_)) => std::cmp::Ordering::Greater,
+            (None, None) => std::cmp::Ordering::Equal,
+        })
+        .unwrap()
+}
+
+/// Reduce `listing` to one entry per backend. A backend reachable from several instances keeps
+/// the entry of the least loaded instance; the loads of those choices and the instances they
+/// were made from are returned by backend name.
+async fn balance_listing(
+    service: &Service,
+    listing: BackendListing,
+) -> (BackendListing, HashMap<String, InstanceChoice>) {
+    let mut groups: Vec<BackendListing> = Vec::new();
+    let mut group_index: HashMap<String, usize> = HashMap::new();
+    for (instance, backend) in listing {
+        match group_index.get(&backend.name) {
+            Some(&i) => groups[i].push((instance, backend)),
+            None => {
+                group_index.insert(backend.name.clone(), groups.len());
+                groups.push(vec![(instance, backend)]);
+            }
+        }
+    }
+    let contested: Vec<(&Instance, &str)> = groups
+        .iter()
+        .filter(|group| group.len() > 1)
+        .flatten()
+        .map(|(instance, backend)| (instance, backend.name.as_str()))
+        .collect();
+    // Reversed so each group below can pop its candidates' loads in listing order.
+    let mut loads: Vec<Option<InstanceLoad>> = futures::stream::iter(contested)
+        .map(|(instance, backend)| instance_load(service, instance, backend))
+        .buffered(MAX_CONCURRENT_REQUESTS)
+        .collect::<Vec<_>>()
+        .await
+        .into_iter()
+        .rev()
+        .collect();
+
+    let mut choices = HashMap::new();
+    let mut balanced = Vec::with_capacity(groups.len());
+    for mut group in groups {
+        if group.len() == 1 {
+            balanced.extend(group);
+            continue;
+        }
+        let group_loads: Vec<Option<InstanceLoad>> =
+            (0..group.len()).map(|_| loads.pop().unwrap()).collect();
+        let candidates: Arc<[Instance]> =
+            group.iter().map(|(instance, _)| instance.clone()).collect();
+        let best = least_loaded(&group_loads);
+        let (instance, backend) = group.swap_remove(best);
+        let mut load = group_loads[best].unwrap_or_default();
+        load.candidates = group_loads.len() as u32;
+        log_info(&format!(
+            "Using backend {} through instance {} ({} active workloads, {:.0}/{:.0} s used) \
+             over {} other instance(s)",
+            backend.name,
+            instance.name.to_str().unwrap(),
+            load.active_workloads,
+            load.usage_consumed_seconds,
+            load.usage_limit_seconds,
+            load.candidates - 1
+        ));
+        choices.insert(backend.name.clone(), InstanceChoice { load, candidates });
+        balanced.push((instance, backend));
+    }
+    (balanced, choices)
+}
+
+/// The instance to submit a job to `backend` through. For a backend chosen among several
+/// instances this is the least loaded of them now, which may differ from the one it was listed
+/// through.
+async fn submit_instance(service: &Service, backend: &Backend) -> Instance {
+    if backend.candidates.len() < 2 {
+        return backend.instance.clone();
+    }
+    let name = backend.response.name.as_str();
+    let loads: Vec<Option<InstanceLoad>> = futures::future::join_all(
+        backend
+            .candidates
+            .iter()
+            .map(|instance| instance_load(service, instance, name)),
+    )
+    .await;
+    let instance = backend.candidates[least_loaded(&loads)].clone();
+    if instance.crn != backend.instance.crn {
+        log_info(&format!(
+            "Submitting to backend {} through instance {} instead of {}",
+            name,
+            instance.name.to_str().unwrap(),
+            backend.instance.name.to_str().unwrap()
+        ));
+    }
+    instance
+}
+
+/// The backend listing for a search, balanced across instances if the service asks for it.
+async fn search_listing(
+    service: &Service,
+) -> Result<(BackendListing, HashMap<String, InstanceChoice>), ServiceError> {
+    let listing = current_listing(service).await?;
+    if service.balance_instances {
+        Ok(balance_listing(service, listing).await)
+    } else {
+        Ok((listing, HashMap::new()))
+    }
+}
+
+pub async fn get_backends(service: &Service) -> Result<BackendSearchResults, ServiceError> {
+    let (listing, choices) = search_listing(service).await?;
+    Ok(BackendSearchResults::from_listing(listing, &choices))
+}
+
+/// Whether a backend search includes simulators.
+#[derive(Copy, Clone, Debug, Default, PartialEq, Eq)]
+#[repr(u32)]
+pub enum SimulatorFilter {
+    /// Include both simulators and hardware.
+    #[default]
+    Any = 0,
+    /// Only hardware backends.
+    Exclude = 1,
+    /// Only simulators.
+    Only = 2,
+}
+
+impl TryFrom<u32> for SimulatorFilter {
+    type Error = u32;
+
+    fn try_from(value: u32) -> Result<Self, u32> {
+        match value {
+            0 => Ok(SimulatorFilter::Any),
+            1 => Ok(SimulatorFilter::Exclude),
+            2 => Ok(SimulatorFilter::Only),
+            _ => Err(value),
+        }
+    }
+}
+
+/// Criteria and ranking weights for [search_backends].
+///
+/// The default query keeps every backend in listing order.
+#[derive(Clone, Debug, Default)]
+pub struct BackendQuery {
+    pub min_qubits: u32,
+    /// Only keep backends that are online.
+    pub operational_only: bool,
+    pub simulator: SimulatorFilter,
+    /// Case-insensitive processor family, e.g. ``"Heron"``.
+    pub processor_family: Option<String>,
+    pub queue_length_weight: f64,
+    pub clops_weight: f64,
+    pub two_q_error_weight: f64,
+    /// Keep only the best ``top_k`` backends, or all of them if 0.
+    pub top_k: usize,
+}
+
+impl BackendQuery {
+    fn matches(&self, backend: &BackendsResponseV2DevicesInner) -> bool {
+        let num_qubits = backend.qubits.flatten().unwrap_or(0);
+        if num_qubits < self.min_qubits as i32 {
+            return false;
+        }
+        if self.operational_only
+            && backend.status.name
+                != models::backends_response_v2_devices_inner_status::Name::Online
+        {
+            return false;
+        }
+        let is_simulator = backend.is_simulator.unwrap_or(false);
+        match self.simulator {
+            SimulatorFilter::Any => (),
+            SimulatorFilter::Exclude if is_simulator => return false,
+            SimulatorFilter::Only if !is_simulator => return false,
+            _ => (),
+        }
+        if let Some(family) = &self.processor_family {
+            let backend_family = backend
+                .processor_type
+                .as_ref()
+                .and_then(|x| x.as_ref())
+                .and_then(|x| x.family.clone().flatten());
+            if !backend_family.is_some_and(|x| x.eq_ignore_ascii_case(family)) {
+                return false;
+            }
+        }
+        true
+    }
+}
+
+/// Scale `values` into [0, 1] across the candidates, where 0 is best. Backends missing the
+/// metric score 1 (worst) so they are never preferred for it.
+fn normalized_metric(values: &[Option<f64>], higher_is_better: bool) -> Vec<f64> {
+    let present = values.iter().flatten();
+    let min = present.clone().copied().fold(f64::INFINITY, f64::min);
+    let max = present.copied().fold(f64::NEG_INFINITY, f64::max);
+    values
+        .iter()
+        .map(|value| match value {
+            Some(value) if max > min => {
+                let x = (value - min) / (max - min);
+                if higher_is_better {
+                    1. - x
+                } else {
+                    x
+                }
+            }
+            Some(_) => 0.,
+            None => 1.,
+        })
+        .collect()
+}
+
+/// Drop the listed backends that don't match `query` and order the rest by weighted score,
+/// best first. Ties keep listing order.
+fn rank_listing(listing: BackendListing, query: &BackendQuery) -> BackendListing {
+    let candidates: BackendListing = listing
+        .into_iter()
+        .filter(|(_, backend)| query.matches(backend))
+        .collect();
+    let queue_lengths: Vec<Option<f64>> = candidates
+        .iter()
+        .map(|(_, backend)| Some(backend.queue_length as f64))
+        .collect();
+    let clops: Vec<Option<f64>> = candidates
+        .iter()
+        .map(|(_, backend)| {
+            backend
+                .clops
+                .as_ref()
+                .and_then(|x| x.as_ref())
+                .map(|x| x.value as f64)
+        })
+        .collect();
+    let two_q_errors: Vec<Option<f64>> = candidates
+        .iter()
+        .map(|(_, backend)| {
+            backend
+                .performance_metrics
+                .as_ref()
+                .and_then(|x| x.two_q_error_layered.as_ref())
+                .map(|x| x.value)
+        })
+        .collect();
+    let queue_lengths = normalized_metric(&queue_lengths, false);
+    let clops = normalized_metric(&clops, true);
+    let two_q_errors = normalized_metric(&two_q_errors, false);
+
+    let mut scored: Vec<(f64, (Instance, BackendsResponseV2DevicesInner))> = candidates
+        .into_iter()
+        .enumerate()
+        .map(|(i, candidate)| {
+            let score = query.queue_length_weight * queue_lengths[i]
+                + query.clops_weight * clops[i]
+                + query.two_q_error_weight * two_q_errors[i];
+            (score, candidate)
+        })
+        .collect();
+    // sort_by is stable, so equal scores keep listing order.
+    scored.sort_by(|a, b| a.0.total_cmp(&b.0));
+    if query.top_k > 0 {
+        scored.truncate(query.top_k);
+    }
+    scored.into_iter().map(|(_, candidate)| candidate).collect()
+}
+
+/// Search the available backends for those matching `query`, best first.
+pub async fn search_backends(
+    service: &Service,
+    query: &BackendQuery,
+) -> Result<BackendSearchResults, ServiceError> {
+    let (listing, choices) = search_listing(service).await?;
+    Ok(BackendSearchResults::from_listing(
+        rank_listing(listing, query),
+        &choices,
+    ))
+}
+
+async fn fetch_backend_status(
+    config: &ibm_quantum_platform_api::apis::configuration::Configuration,
+    backend: &Backend,
+) -> Result<(i32, BackendStatus), ServiceError> {
+    let resp = get_backend_status(
+        config,
+        backend.response.name.as_str(),
+        backend.instance.crn.to_str().unwrap(),
+        Some("2025-06-01"),
+    )
+    .await?;
+    log_debug(&format!("get_backend_status response: {:?}", &resp));
+    Ok((
+        resp.length_queue,
+        BackendStatus::from_status_response(&resp),
+    ))
+}
+
+/// Refresh the live fields (status and queue length) of a backend in place.
+pub async fn refresh_backend_status(
+    service: &Service,
+    backend: &Backend,
+) -> Result<(), ServiceError> {
+    let (queue_length, status) = fetch_backend_status(&service.quantum_config, backend).await?;
+    backend.update_live(queue_length, status);
+    Ok(())
+}
+
+/// How many polls in a row may fail before a [BackendWatcher] reports the backend offline.
+pub const WATCHER_MAX_FAILURES: u32 = 3;
+
+/// Called by a [BackendWatcher] with the position of a backend among the watched ones, the
+/// backend, its new status and its new queue length.
+pub type StatusCallback = Box<dyn FnMut(usize, &Backend, BackendStatus, i32) + Send>;
+
+/// Keeps the status and queue length of a set of backends current from a background thread.
+///
+/// Clones of a [Backend] share their live fields, so every handle the caller holds sees the
+/// refreshed values. The callback runs on the watcher thread whenever a backend's status
+/// changes (e.g. it goes offline) or its queue length moves by more than the threshold since it
+/// was last reported. A backend whose status can't be fetched for [WATCHER_MAX_FAILURES] polls
+/// in a row is reported offline. Dropping the watcher stops the thread.
+pub struct BackendWatcher {
+    stop: Option<mpsc::Sender<()>>,
+    handle: Option<JoinHandle<()>>,
+}
+
+impl BackendWatcher {
+    pub fn new(
+        service: &Service,
+        backends: Vec<Backend>,
+        interval: Duration,
+        queue_threshold: i32,
+        mut on_change: StatusCallback,
+    ) -> Result<Self, ServiceError> {
+        if interval.is_zero() {
+            return Err(ServiceError {
+                code: ExitCode::BadArgumentError,
+                message: "The interval between backend status polls must be positive".to_string(),
             });
-            ptrs.push(backend.as_ref() as *const Backend);
-            backends.push(backend);
         }
+        let mut config = service.quantum_config.clone();
+        let account = service.account.clone();
+        let (stop, stopped) = mpsc::channel::<()>();
+        let handle = std::thread::spawn(move || {
+            let rt = tokio::runtime::Builder::new_current_thread()
+                .enable_all()
+                .build()
+                .unwrap();
+            let mut reported: Vec<(BackendStatus, i32)> = backends
+                .iter()
+                .map(|b| (b.status(), b.queue_length()))
+                .collect();
+            let mut failures = vec![0u32; backends.len()];
+            let poll = |config: &ibm_quantum_platform_api::apis::configuration::Configuration| {
+                rt.block_on(
+                    futures::stream::iter(&backends)
+                        .map(|backend| fetch_backend_status(config, backend))
+                        .buffered(MAX_CONCURRENT_REQUESTS)
+                        .collect::<Vec<_>>(),
+                )
+            };
+            // Sleep until the next poll, or until the watcher is dropped and hangs up.
+            while let Err(RecvTimeoutError::Timeout) = stopped.recv_timeout(interval) {
+                let mut statuses = poll(&config);
+                let unauthenticated = statuses.iter().any(|status| {
+                    matches!(status, Err(e) if matches!(e.code, ExitCode::QuantumAPIUnauthenticated))
+                });
+                if unauthenticated {
+                    // The access token has expired: get a new one and poll again with it.
+                    match rt.block_on(request_token(&account.iam_config, &account.config)) {
+                        Ok(token) => {
+                            config.api_key = token.access_token.as_deref().map(quantum_api_key);
+                            statuses = poll(&config);
+                        }
+                        Err(e) => log_warn(&format!(
+                            "Failed to renew the access token of the backend watcher: {}",
+                            e
+                        )),
+                    }
+                }
+                let watched = backends.iter().zip(&mut reported).zip(&mut failures);
+                for (index, (((backend, last), failures), status)) in
+                    watched.zip(statuses).enumerate()
+                {
+                    let (queue_length, status) = match status {
+                        Ok(x) => {
+                            *failures = 0;
+                            x
+                        }
+                        Err(e) => {
+                            log_warn(&format!(
+                                "Failed to refresh the status of backend {}: {}",
+                                backend.response.name, e
+                            ));
+                            *failures += 1;
+                            if *failures < WATCHER_MAX_FAILURES {
+                                continue;
+                            }
+                            // Don't keep reporting a status that can no longer be checked.
+                            (backend.queue_length(), BackendStatus::Offline)
+                        }
+                    };
+                    backend.update_live(queue_length, status);
+                    if status != last.0 || (queue_length - last.1).abs() > queue_threshold {
+                        *last = (status, queue_length);
+                        on_change(index, backend, status, queue_length);
+                    }
+                }
+            }
+        });
+        Ok(BackendWatcher {
+            stop: Some(stop),
+            handle: Some(handle),
+        })
+    }
+}
+
+impl Drop for BackendWatcher {
+    fn drop(&mut self) {
+        drop(self.stop.take());
+        if let Some(handle) = self.handle.take() {
+            let _ = handle.join();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::test_server::{serve, Response};
+
+    fn test_account() -> Account {
+        let token = TokenResponse {
+            access_token: Some("test-access-token".to_string()),
+            ..Default::default()
+        };
+        let iam_config = Configuration::default();
+        Account {
+            search_config: search_config(&iam_config, &token),
+            config: AccountEntry {
+                channel: "ibm_quantum_platform".to_string(),
+                instance: None,
+                private_endpoint: false,
+                token: "test-api-key".to_string(),
+                url: "https://cloud.ibm.com".to_string(),
+                proxies: None,
+                verify: true,
+            },
+            token,
+            iam_config,
+        }
+    }
+
+    fn test_instance(index: usize) -> Instance {
+        Instance {
+            crn: CString::new(format!("crn:v1:test:instance-{}", index)).unwrap(),
+            name: CString::new(format!("instance-{}", index)).unwrap(),
+        }
+    }
+
+    fn devices_response(name: &str) -> String {
+        format!(
+            r#"{{"devices": [{{"name": "{}", "status": {{"name": "online"}}, "queue_length": 3}}]}}"#,
+            name
+        )
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn list_all_backends_is_concurrent_and_ordered() {
+        const NUM_INSTANCES: usize = 6;
+        const FAILING_INSTANCE: usize = 2;
+        let delay = Duration::from_millis(300);
+        let base_path = serve(move |request| {
+            let crn = request
+                .headers
+                .get("service-crn")
+                .cloned()
+                .unwrap_or_default();
+            let index: usize = crn.rsplit('-').next().unwrap().parse().unwrap();
+            if index == FAILING_INSTANCE {
+                return Response::status(500).delayed(delay);
+            }
+            // Answer in reverse order so the listing order can't just follow completion order.
+            Response::json(devices_response(&format!("backend_{}", index)))
+                .delayed(delay * (NUM_INSTANCES - index) as u32 / NUM_INSTANCES as u32)
+        })
+        .await;
+
+        let instances = (0..NUM_INSTANCES).map(test_instance).collect();
+        let mut service = Service::new(test_account(), instances);
+        service.quantum_config.base_path = base_path;
+
+        let start = Instant::now();
+        let listing = list_all_backends(&service).await.unwrap();
+        let elapsed = start.elapsed();
+
+        let names: Vec<(String, String)> = listing
+            .iter()
+            .map(|(instance, device)| {
+                (
+                    instance.name.to_str().unwrap().to_string(),
+                    device.name.clone(),
+                )
+            })
+            .collect();
+        let expected: Vec<(String, String)> = (0..NUM_INSTANCES)
+            .filter(|&i| i != FAILING_INSTANCE)
+            .map(|i| (format!("instance-{}", i), format!("backend_{}", i)))
+            .collect();
+        assert_eq!(names, expected);
+        // Sequential listing would take the sum of the delays (about 4 * delay); concurrent
+        // listing takes about the longest one.
+        assert!(
+            elapsed < delay * 2,
+            "listing took {:?}, expected less than {:?}",
+            elapsed,
+            delay * 2
+        );
+    }
+
+    fn listed_backend(json: &str) -> (Instance, BackendsResponseV2DevicesInner) {
+        (test_instance(0), serde_json::from_str(json).unwrap())
+    }
+
+    #[test]
+    fn simulator_filter_from_u32() {
+        for filter in [
+            SimulatorFilter::Any,
+            SimulatorFilter::Exclude,
+            SimulatorFilter::Only,
+        ] {
+            assert_eq!(SimulatorFilter::try_from(filter as u32), Ok(filter));
+        }
+        assert_eq!(SimulatorFilter::try_from(3), Err(3));
+    }
+
+    #[test]
+    fn rank_listing_filters_and_orders() {
+        let listing = vec![
+            listed_backend(
+                r#"{"name": "busy_heron", "status": {"name": "online"}, "queue_length": 90,
+                    "qubits": 156, "processor_type": {"family": "Heron"},
+                    "performance_metrics": {"two_q_error_layered": {"value": 0.004}}}"#,
+            ),
+            listed_backend(
+                r#"{"name": "idle_heron", "status": {"name": "online"}, "queue_length": 10,
+                    "qubits": 133, "processor_type": {"family": "Heron"},
+                    "performance_metrics": {"two_q_error_layered": {"value": 0.008}}}"#,
+            ),
+            listed_backend(
+                r#"{"name": "paused_heron", "status": {"name": "paused"}, "queue_length": 0,
+                    "qubits": 156, "processor_type": {"family": "Heron"}}"#,
+            ),
+            listed_backend(
+                r#"{"name": "small_eagle", "status": {"name": "online"}, "queue_length": 0,
+                    "qubits": 27, "processor_type": {"family": "Eagle"}}"#,
+            ),
+        ];
+        let names = |listing: BackendListing| -> Vec<String> {
+            listing.into_iter().map(|(_, b)| b.name).collect()
+        };
+
+        let query = BackendQuery {
+            min_qubits: 100,
+            operational_only: true,
+            processor_family: Some("heron".to_string()),
+            queue_length_weight: 1.,
+            ..Default::default()
+        };
+        assert_eq!(
+            names(rank_listing(listing.clone(), &query)),
+            ["idle_heron", "busy_heron"]
+        );
+
+        let query = BackendQuery {
+            two_q_error_weight: 2.,
+            top_k: 2,
+            ..query
+        };
+        assert_eq!(
+            names(rank_listing(listing.clone(), &query)),
+            ["busy_heron", "idle_heron"]
+        );
+
+        // The default query keeps everything in listing order.
+        assert_eq!(
+            names(rank_listing(listing.clone(), &BackendQuery::default())),
+            names(listing)
+        );
+    }
+
+    #[test]
+    fn backend_watcher_reports_changes() {
+        let rt = tokio::runtime::Runtime::new().unwrap();
+        let polls = Arc::new(std::sync::atomic::AtomicUsize::new(0));
+        let server_polls = polls.clone();
+        let base_path = rt.block_on(serve(move |request| {
+            assert_eq!(request.path, "/v1/backends/watched/status");
+            // Starting from a queue of 3: a small change, a large one, then an outage.
+            match server_polls.fetch_add(1, Ordering::SeqCst) {
+                0 => Response::json(r#"{"state": true, "status": "active", "length_queue": 5}"#),
+                1 => Response::json(r#"{"state": true, "status": "active", "length_queue": 40}"#),
+                _ => Response::json(r#"{"state": false, "status": "offline", "length_queue": 40}"#),
+            }
+        }));
+        let mut service = Service::new(test_account(), vec![]);
+        service.quantum_config.base_path = base_path;
+        let (_, device) = listed_backend(
+            r#"{"name": "watched", "status": {"name": "online"}, "queue_length": 3}"#,
+        );
+        let backend = Backend::new(test_instance(0), device);
+
+        let (sender, changes) = mpsc::channel();
+        let watcher = BackendWatcher::new(
+            &service,
+            vec![backend.clone()],
+            Duration::from_millis(20),
+            10,
+            Box::new(move |index, backend, status, queue_length| {
+                let _ = sender.send((index, backend.response.name.clone(), status, queue_length));
+            }),
+        )
+        .unwrap();
+        let timeout = Duration::from_secs(5);
+        assert_eq!(
+            changes.recv_timeout(timeout).unwrap(),
+            (0, "watched".to_string(), BackendStatus::Online, 40)
+        );
+        assert_eq!(
+            changes.recv_timeout(timeout).unwrap(),
+            (0, "watched".to_string(), BackendStatus::Offline, 40)
+        );
+        drop(watcher);
+        // The caller's handle shares the refreshed fields.
+        assert_eq!(backend.status(), BackendStatus::Offline);
+        assert_eq!(backend.queue_length(), 40);
+        assert!(polls.load(Ordering::SeqCst) >= 3);
+    }
+
+    #[test]
+    fn backend_watcher_renews_token_and_reports_failures() {
+        let rt = tokio::runtime::Runtime::new().unwrap();
+        let polls = Arc::new(std::sync::atomic::AtomicUsize::new(0));
+        let server_polls = polls.clone();
+        let base_path = rt.block_on(serve(move |request| {
+            if request.path.starts_with("/identity/token") {
+                return Response::json(r#"{"access_token": "renewed-access-token"}"#);
+            }
+            // The token the service started with has expired.
+            if request.headers.get("authorization").map(String::as_str)
+                != Some("Bearer renewed-access-token")
+            {
+                return Response::status(401);
+            }
+            // One good poll, then the status endpoint stops answering.
+            match server_polls.fetch_add(1, Ordering::SeqCst) {
+                0 => Response::json(r#"{"state": true, "status": "active", "length_queue": 40}"#),
+                _ => Response::status(500),
+            }
+        }));
+        let mut account = test_account();
+        account.iam_config.base_path = base_path.clone();
+        let mut service = Service::new(account, vec![]);
+        service.quantum_config.base_path = base_path;
+        let (_, device) = listed_backend(
+            r#"{"name": "watched", "status": {"name": "online"}, "queue_length": 3}"#,
+        );
+        let backend = Backend::new(test_instance(0), device);
+
+        let (sender, changes) = mpsc::channel();
+        let watcher = BackendWatcher::new(
+            &service,
+            vec![backend.clone()],
+            Duration::from_millis(20),
+            10,
+            Box::new(move |index, _, status, queue_length| {
+                let _ = sender.send((index, status, queue_length));
+            }),
+        )
+        .unwrap();
+        let timeout = Duration::from_secs(5);
+        assert_eq!(
+            changes.recv_timeout(timeout).unwrap(),
+            (0, BackendStatus::Online, 40)
+        );
+        assert_eq!(
+            changes.recv_timeout(timeout).unwrap(),
+            (0, BackendStatus::Offline, 40)
+        );
+        drop(watcher);
+        assert_eq!(backend.status(), BackendStatus::Offline);
+        assert!(polls.load(Ordering::SeqCst) > WATCHER_MAX_FAILURES as usize);
+    }
+
+    #[test]
+    fn backend_watcher_rejects_zero_interval() {
+        let service = Service::new(test_account(), vec![]);
+        let watcher = BackendWatcher::new(
+            &service,
+            vec![],
+            Duration::ZERO,
+            10,
+            Box::new(|_, _, _, _| {}),
+        );
+        assert!(matches!(
+            watcher,
+            Err(ServiceError {
+                code: ExitCode::BadArgumentError,
+                ..
+            })
+        ));
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn discovery_pages_overlap_backend_listing() {
+        const NUM_PAGES: usize = 5;
+        const PER_PAGE: usize = 3;
+        let delay = Duration::from_millis(50);
+        let events = Arc::new(Mutex::new(Vec::new()));
+        let server_events = events.clone();
+        let base_path = serve(move |request| {
+            if request.path.starts_with("/v3/resources/search") {
+                let body: serde_json::Value = serde_json::from_str(&request.body).unwrap();
+                let page = match body["search_cursor"].as_str() {
+                    Some(cursor) => cursor.strip_prefix("page-").unwrap().parse().unwrap(),
+                    None => 0,
+                };
+                server_events
+                    .lock()
+                    .unwrap()
+                    .push(format!("search {}", page));
+                if page == NUM_PAGES {
+                    return Response::json(r#"{"limit": 100, "items": []}"#).delayed(delay);
+                }
+                let items: Vec<_> = (0..PER_PAGE)
+                    .map(|i| {
+                        let index = page * PER_PAGE + i;
+                        serde_json::json!({
+                            "crn": format!("crn:v1:test:instance-{}", index),
+                            "name": format!("instance-{}", index),
+                            "doc": {"extensions": {}},
+                        })
+                    })
+                    .collect();
+                let body = serde_json::json!({
+                    "limit": 100,
+                    "items": items,
+                    "search_cursor": format!("page-{}", page + 1),
+                });
+                return Response::json(body.to_string()).delayed(delay);
+            }
+            let crn = request.headers.get("service-crn").cloned().unwrap();
+            let index: usize = crn.rsplit('-').next().unwrap().parse().unwrap();
+            server_events
+                .lock()
+                .unwrap()
+                .push(format!("list {}", index));
+            Response::json(devices_response(&format!("backend_{}", index))).delayed(delay)
+        })
+        .await;
+
+        let mut account = test_account();
+        account.search_config.base_path = base_path.clone();
+        let mut service = Service::new_lazy(account);
+        service.quantum_config.base_path = base_path;
+
+        let listing = list_all_backends(&service).await.unwrap();
+        let names: Vec<String> = listing.into_iter().map(|(_, b)| b.name).collect();
+        let expected: Vec<String> = (0..NUM_PAGES * PER_PAGE)
+            .map(|i| format!("backend_{}", i))
+            .collect();
+        assert_eq!(names, expected);
+        assert_eq!(
+            service.instances().await.unwrap().len(),
+            NUM_PAGES * PER_PAGE
+        );
+
+        // Listing of the first page's instances started before the last page was requested.
+        let events = events.lock().unwrap();
+        let first_listing = events.iter().position(|x| x.starts_with("list")).unwrap();
+        let last_page = events
+            .iter()
+            .position(|x| *x == format!("search {}", NUM_PAGES))
+            .unwrap();
+        assert!(first_listing < last_page, "events: {:?}", events);
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn balanced_search_uses_least_loaded_instance() {
+        // instance-0 and instance-1 both reach "shared"; instance-1 has fewer active workloads
+        // until `busy` is set. Only instance-0 reaches "solo".
+        let load_requests = Arc::new(std::sync::atomic::AtomicUsize::new(0));
+        let busy = Arc::new(std::sync::atomic::AtomicBool::new(false));
+        let (server_requests, server_busy) = (load_requests.clone(), busy.clone());
+        let base_path = serve(move |request| {
+            let crn = request.headers.get("service-crn").cloned().unwrap();
+            let index: usize = crn.rsplit('-').next().unwrap().parse().unwrap();
+            if !request.path.starts_with("/v1/backends") {
+                server_requests.fetch_add(1, Ordering::SeqCst);
+            }
+            if request.path.starts_with("/v1/instances/usage") {
+                return Response::json(format!(
+                    r#"{{"instance_id": "{}", "plan_id": "plan", "usage_consumed_seconds": 100,
+                        "usage_limit_seconds": 600}}"#,
+                    crn
+                ));
+            }
+            if request.path.starts_with("/v1/workloads") {
+                assert!(request.path.contains("backend=shared"));
+                let active = [7, [2, 9][server_busy.load(Ordering::SeqCst) as usize]][index];
+                return Response::json(format!(
+                    r#"{{"workloads": [], "total_count": {}, "limit": 1}}"#,
+                    active
+                ));
+            }
+            let names: &[&str] = [&["solo", "shared"][..], &["shared"][..]][index];
+            let devices: Vec<String> = names
+                .iter()
+                .map(|name| {
+                    format!(
+                        r#"{{"name": "{}", "status": {{"name": "online"}}, "queue_length": 0}}"#,
+                        name
+                    )
+                })
+                .collect();
+            Response::json(format!(r#"{{"devices": [{}]}}"#, devices.join(",")))
+        })
+        .await;
+        let mut service = Service::new(test_account(), (0..2).map(test_instance).collect());
+        service.quantum_config.base_path = base_path;
+        service.enable_instance_balancing();
+
+        let results = get_backends(&service).await.unwrap();
+        let chosen: Vec<(String, String, u32, u32)> = results
+            .backends()
+            .map(|b| {
+                (
+                    b.response.name.clone(),
+                    b.instance.name.to_str().unwrap().to_string(),
+                    b.instance_load().candidates,
+                    b.instance_load().active_workloads,
+                )
+            })
+            .collect();
+        assert_eq!(
+            chosen,
+            [
+                ("solo".to_string(), "instance-0".to_string(), 0, 0),
+                ("shared".to_string(), "instance-1".to_string(), 2, 2),
+            ]
+        );
+        assert_eq!(load_requests.load(Ordering::SeqCst), 4);
+
+        // Loads are reused for a while by later searches and submissions.
+        let results = get_backends(&service).await.unwrap();
+        let shared = results.backends().nth(1).unwrap();
+        let instance = submit_instance(&service, shared).await;
+        assert_eq!(instance.name.to_str().unwrap(), "instance-1");
+        assert_eq!(load_requests.load(Ordering::SeqCst), 4);
+
+        // Once they expire, submission goes through whichever instance is least loaded now.
+        busy.store(true, Ordering::SeqCst);
+        service.instance_load_ttl = Duration::ZERO;
+        let instance = submit_instance(&service, shared).await;
+        assert_eq!(instance.name.to_str().unwrap(), "instance-0");
+        assert_eq!(load_requests.load(Ordering::SeqCst), 8);
+        // Backends reachable from one instance are submitted through it without requests.
+        let solo = results.backends().next().unwrap();
+        assert_eq!(submit_instance(&service, solo).await.crn, solo.instance.crn);
+        assert_eq!(load_requests.load(Ordering::SeqCst), 8);
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn target_documents_are_fetched_concurrently() {
+        let (configuration, properties) = crate::backend_data::tests::heron_documents();
+        let delay = Duration::from_millis(300);
+        let base_path = serve(move |request| {
+            let body = if request.path.ends_with("/configuration") {
+                configuration.clone()
+            } else if request.path.starts_with("/v1/backends/ibm_missing/") {
+                return Response::status(404);
+            } else {
+                properties.clone()
+            };
+            Response::json(body).delayed(delay)
+        })
+        .await;
+        let mut service = Service::new(test_account(), vec![test_instance(0)]);
+        service.quantum_config.base_path = base_path;
+
+        let start = Instant::now();
+        fetch_target_data(&service, "ibm_heron", "crn:v1:test:instance-0")
+            .await
+            .unwrap();
+        let elapsed = start.elapsed();
+        assert!(
+            elapsed < delay * 2,
+            "fetching the target took {:?}, expected less than {:?}",
+            elapsed,
+            delay * 2
+        );
+
+        let error = fetch_target_data(&service, "ibm_missing", "crn:v1:test:instance-0")
+            .await
+            .unwrap_err();
+        assert!(matches!(error.code(), ExitCode::QuantumAPINotFound));
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn target_cache_follows_calibration() {
+        let (configuration, properties) = crate::backend_data::tests::heron_documents();
+        let first = "2025-06-01T08:00:00Z";
+        let calibration = Arc::new(Mutex::new(first.to_string()));
+        let requests = Arc::new(Mutex::new(Vec::new()));
+        let base_path = serve({
+            let calibration = calibration.clone();
+            let requests = requests.clone();
+            move |request| {
+                let document = request.path.rsplit('/').next().unwrap().to_string();
+                requests.lock().unwrap().push(document.clone());
+                if document == "configuration" {
+                    Response::json(configuration.clone())
+                } else {
+                    Response::json(properties.replace(first, &calibration.lock().unwrap()))
+                }
+            }
+        })
+        .await;
+        let mut service = Service::new(test_account(), vec![test_instance(0)]);
+        service.quantum_config.base_path = base_path;
+        service.target_cache = TargetCache::in_memory();
+        let take_requests = || {
+            let mut taken = std::mem::take(&mut *requests.lock().unwrap());
+            taken.sort();
+            taken
+        };
+        let get = || cached_target(&service, "ibm_heron", "crn:v1:test:instance-0");
+
+        get().await.unwrap();
+        assert_eq!(take_requests(), ["configuration", "properties"]);
+        get().await.unwrap();
+        assert!(take_requests().is_empty());
+
+        // Once stale, an unchanged calibration costs only the properties.
+        service.target_cache.expire("ibm_heron");
+        get().await.unwrap();
+        assert_eq!(take_requests(), ["properties"]);
+
+        let second = "2025-06-01T09:00:00Z";
+        *calibration.lock().unwrap() = second.to_string();
+        service.target_cache.expire("ibm_heron");
+        get().await.unwrap();
+        assert_eq!(take_requests(), ["configuration", "properties"]);
+        let hit = service.target_cache.get("ibm_heron", |_| ()).unwrap();
+        assert_eq!(hit.data.calibration.as_deref(), Some(second));
+        assert!(hit.fresh);
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn backend_target_refreshes_from_its_own_snapshot() {
+        let (configuration, properties) = crate::backend_data::tests::heron_documents();
+        let first = "2025-06-01T08:00:00Z";
+        let recalibrated = Arc::new(std::sync::atomic::AtomicBool::new(false));
+        let base_path = serve({
+            let recalibrated = recalibrated.clone();
+            move |request| {
+                if request.path.ends_with("/configuration") {
+                    Response::json(configuration.clone())
+                } else if recalibrated.load(Ordering::SeqCst) {
+                    Response::json(
+                        properties
+                            .replace(first, "2025-06-01T09:00:00Z")
+                            .replace("0.003", "0.004"),
+                    )
+                } else {
+                    Response::json(properties.clone())
+                }
+            }
+        })
+        .await;
+        let mut service = Service::new(test_account(), vec![test_instance(0)]);
+        service.quantum_config.base_path = base_path;
+        service.target_cache = TargetCache::in_memory();
+        let (_, device) = listed_backend(
+            r#"{"name": "ibm_heron", "status": {"name": "online"}, "queue_length": 0}"#,
+        );
+        let backend = Backend::new(test_instance(0), device);
+
+        let mut first_target = get_backend_target(&service, &backend).await.unwrap();
+        let mut second_target = get_backend_target(&service, &backend).await.unwrap();
+        let refresh = refresh_target(&service, &mut first_target).await.unwrap();
+        assert_eq!((refresh.updated, refresh.not_applied), (0, 0));
+
+        recalibrated.store(true, Ordering::SeqCst);
+        service.target_cache.expire("ibm_heron");
+        let refresh = refresh_target(&service, &mut first_target).await.unwrap();
+        assert!(refresh.updated > 0);
+        assert_eq!(refresh.not_applied, 0);
+        let refresh = refresh_target(&service, &mut first_target).await.unwrap();
+        assert_eq!(refresh.updated, 0);
+
+        // Each handle tracks what its own target was last brought up to date with.
+        let refresh = refresh_target(&service, &mut second_target).await.unwrap();
+        assert!(refresh.updated > 0);
+    }
+
+    #[tokio::test(flavor = "multi_thread")]
+    async fn target_prefetch_is_bounded_and_shared() {
+        let (configuration, properties) = crate::backend_data::tests::heron_documents();
+        let delay = Duration::from_millis(200);
+        let requests = Arc::new(Mutex::new(Vec::new()));
+        let base_path = serve({
+            let requests = requests.clone();
+            move |request| {
+                requests.lock().unwrap().push(request.path.clone());
+                let body = if request.path.ends_with("/configuration") {
+                    configuration.clone()
+                } else {
+                    properties.clone()
+                };
+                Response::json(body).delayed(delay)
+            }
+        })
+        .await;
+        let mut service = Service::new(test_account(), vec![test_instance(0)]);
+        service.quantum_config.base_path = base_path;
+        service.target_cache = TargetCache::in_memory();
+        service.limit_target_cache(2);
+        let backends: Vec<(String, String)> = ["ibm_a", "ibm_b", "ibm_c"]
+            .iter()
+            .map(|name| (name.to_string(), "crn:v1:test:instance-0".to_string()))
+            .collect();
+
+        // Only as many targets as the cache holds are prefetched, one backend at a time.
+        let start = Instant::now();
+        let prefetch = service.spawn_target_prefetch(backends, 1);
+        // A request for a backend being prefetched waits for the prefetch instead of
+        // fetching again.
+        tokio::time::sleep(delay / 2).await;
+        cached_target(&service, "ibm_a", "crn:v1:test:instance-0")
+            .await
+            .unwrap();
+        tokio::task::spawn_blocking(|| prefetch.join().unwrap())
+            .await
+            .unwrap();
+        let elapsed = start.elapsed();
+        assert!(
+            elapsed >= delay * 2,
+            "prefetching two targets one at a time took {:?}",
+            elapsed
+        );
+        let mut paths = std::mem::take(&mut *requests.lock().unwrap());
+        paths.sort();
+        assert_eq!(
+            paths,
+            [
+                "/v1/backends/ibm_a/configuration",
+                "/v1/backends/ibm_a/properties",
+                "/v1/backends/ibm_b/configuration",
+                "/v1/backends/ibm_b/properties",
+            ]
+        );
+        assert_eq!(
+            service.target_cache.backends_in_memory(),
+            ["ibm_a", "ibm_b"]
+        );
+
+        // Building a third target evicts the least recently used one.
+        cached_target(&service, "ibm_a", "crn:v1:test:instance-0")
+            .await
+            .unwrap();
+        cached_target(&service, "ibm_c", "crn:v1:test:instance-0")
+            .await
+            .unwrap();
+        assert_eq!(
+            service.target_cache.backends_in_memory(),
+            ["ibm_a", "ibm_c"]
+        );
+    }
+
+    /// Compare decoding the responses of the endpoints with large bodies into the types the
+    /// client reads them as, from a `String` copy as the generated client did and from the bytes
+    /// with each [JsonDecoder] engine built in. Runs on the recorded Heron documents and on
+    /// results and a job list of typical size.
+    ///
+    /// Run with ``cargo test --release -- --ignored --nocapture bench_``, and add
+    /// ``--features simd-json`` to include simd-json.
+    #[test]
+    #[ignore]
+    #[allow(clippy::print_stderr)]
+    fn bench_response_decoding() {
+        use crate::backend_data::BackendProperties;
+        use ibm_quantum_platform_api::apis::{JsonDecoder, SerdeJsonDecoder};
+
+        // Each decode gets its own copy of the body, since engines may decode in place.
+        macro_rules! compare_decoding {
+            ($name:expr, $body:expr, $ty:ty) => {{
+                let body: &[u8] = $body;
+                let iterations = 20;
+                let time = |decode: &dyn Fn()| {
+                    let start = Instant::now();
+                    for _ in 0..iterations {
+                        decode();
+                    }
+                    start.elapsed() / iterations
+                };
+                let from_text = time(&|| {
+                    let text = String::from_utf8_lossy(body).into_owned();
+                    std::hint::black_box(serde_json::from_str::<$ty>(&text).unwrap());
+                });
+                let serde_json = time(&|| {
+                    let mut body = body.to_vec();
+                    std::hint::black_box(SerdeJsonDecoder::decode::<$ty>(&mut body).unwrap());
+                });
+                #[cfg(feature = "simd-json")]
+                let simd_json = format!(
+                    ", simd-json {:?}",
+                    time(&|| {
+                        use ibm_quantum_platform_api::apis::SimdJsonDecoder;
+                        let mut body = body.to_vec();
+                        std::hint::black_box(SimdJsonDecoder::decode::<$ty>(&mut body).unwrap());
+                    })
+                );
+                #[cfg(not(feature = "simd-json"))]
+                let simd_json = String::new();
+                eprintln!(
+                    "{} ({} bytes): serde_json from String {:?}, serde_json {:?}{} per decode",
+                    $name,
+                    body.len(),
+                    from_text,
+                    serde_json,
+                    simd_json
+                );
+            }};
+        }
+
+        let (configuration, properties) = crate::backend_data::tests::heron_documents();
+        let entry = |seed: u64| models::sampler_v2_job_result::SamplerV2ResultEntry {
+            data: HashMap::from([(
+                "meas".to_string(),
+                models::sampler_v2_job_result::SamplerV2ResultEntryData {
+                    samples: (0..100_000u64)
+                        .map(|shot| format!("0x{:x}", (shot ^ seed).wrapping_mul(0x9e37_79b9) >> 8))
+                        .collect(),
+                    num_bits: 56,
+                },
+            )]),
+            metadata: serde_json::json!({"circuit_metadata": {}}),
+        };
+        let results = SamplerV2Result {
+            metadata: serde_json::json!({"version": 2}),
+            results: (0..4).map(entry).collect(),
+        };
+        let mut jobs = models::JobsResponse::new(0, 200);
+        jobs.jobs = Some(vec![models::JobResponse::default(); 200]);
+        jobs.count = Some(200);
+
+        compare_decoding!(
+            "configuration",
+            configuration.as_bytes(),
+            BackendConfiguration
+        );
+        compare_decoding!("properties", properties.as_bytes(), BackendProperties);
+        compare_decoding!(
+            "results",
+            &serde_json::to_vec(&results).unwrap(),
+            SamplerV2Result
+        );
+        compare_decoding!(
+            "jobs",
+            &serde_json::to_vec(&jobs).unwrap(),
+            models::JobsResponse
+        );
     }
-    Ok(BackendSearchResults { backends, ptrs })
 }
@@ -0,0 +1,138 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! A minimal local HTTP server standing in for the IBM Cloud APIs in unit tests.
+
+use std::collections::HashMap;
+use std::sync::Arc;
+use std::time::Duration;
+
+use tokio::io::{AsyncReadExt, AsyncWriteExt};
+use tokio::net::{TcpListener, TcpStream};
+
+pub struct Request {
+    pub method: String,
+    pub path: String,
+    /// Header names are lower-cased.
+    pub headers: HashMap<String, String>,
+    pub body: String,
+}
+
+pub struct Response {
+    pub status: u16,
+    pub body: String,
+    /// Time to wait before answering, to model a slow endpoint.
+    pub delay: Duration,
+}
+
+impl Response {
+    pub fn json(body: impl Into<String>) -> Self {
+        Response {
+            status: 200,
+            body: body.into(),
+            delay: Duration::ZERO,
+        }
+    }
+
+    pub fn status(status: u16) -> Self {
+        Response {
+            status,
+            body: "{}".to_string(),
+            delay: Duration::ZERO,
+        }
+    }
+
+    pub fn delayed(mut self, delay: Duration) -> Self {
+        self.delay = delay;
+        self
+    }
+}
+
+/// Start serving on an ephemeral local port, answering every request with `handler`.
+///
+/// Returns the base URL of the server. The server runs until the test's runtime shuts down.
+pub async fn serve<F>(handler: F) -> String
+where
+    F: Fn(&Request) -> Response + Send + Sync + 'static,
+{
+    let listener = TcpListener::bind("127.0.0.1:0").await.unwrap();
+    let addr = listener.local_addr().unwrap();
+    let handler = Arc::new(handler);
+    tokio::spawn(async move {
+        loop {
+            let Ok((stream, _)) = listener.accept().await else {
+                return;
+            };
+            let handler = handler.clone();
+            tokio::spawn(async move {
+                let _ = handle_connection(stream, handler.as_ref()).await;
+            });
+        }
+    });
+    format!("http://{}", addr)
+}
+
+async fn handle_connection<F>(mut stream: TcpStream, handler: &F) -> std::io::Result<()>
+where
+    F: Fn(&Request) -> Response,
+{
+    let mut buf = Vec::new();
+    let mut chunk = [0u8; 4096];
+    let header_end = loop {
+        let n = stream.read(&mut chunk).await?;
+        if n == 0 {
+            return Ok(());
+        }
+        buf.extend_from_slice(&chunk[..n]);
+        if let Some(pos) = buf.windows(4).position(|w| w == b"\r\n\r\n") {
+            break pos + 4;
+        }
+    };
+    let head = String::from_utf8_lossy(&buf[..header_end]).to_string();
+    let mut lines = head.split("\r\n");
+    let mut request_line = lines.next().unwrap_or_default().split(' ');
+    let method = request_line.next().unwrap_or_default().to_string();
+    let path = request_line.next().unwrap_or_default().to_string();
+    let headers: HashMap<String, String> = lines
+        .filter_map(|line| line.split_once(':'))
+        .map(|(k, v)| (k.trim().to_lowercase(), v.trim().to_string()))
+        .collect();
+    let content_length: usize = headers
+        .get("content-length")
+        .and_then(|x| x.parse().ok())
+        .unwrap_or(0);
+    while buf.len() < header_end + content_length {
+        let n = stream.read(&mut chunk).await?;
+        if n == 0 {
+            break;
+        }
+        buf.extend_from_slice(&chunk[..n]);
+    }
+    let body = String::from_utf8_lossy(&buf[header_end..]).to_string();
+    let response = handler(&Request {
+        method,
+        path,
+        headers,
+        body,
+    });
+    if !response.delay.is_zero() {
+        tokio::time::sleep(response.delay).await;
+    }
+    let head = format!(
+        "HTTP/1.1 {} Stand-in\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+        response.status,
+        response.body.len()
+    );
+    stream.write_all(head.as_bytes()).await?;
+    stream.write_all(response.body.as_bytes()).await?;
+    stream.shutdown().await
+}
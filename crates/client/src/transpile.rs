@@ -0,0 +1,288 @@
+// This code is part of Qiskit.
+//
+// (C) Copyright IBM 2025
+//
+// This code is licensed under the Apache License, Version 2.0. You may
+// obtain a copy of this license in the LICENSE.txt file in the root directory
+// of this source tree or at http://www.apache.org/licenses/LICENSE-2.0.
+//
+// Any modifications or derivative works of this code must retain this
+// copyright notice, and modified files need to carry a notice indicating
+// that they have been altered from the originals.
+
+//! Transpiling a circuit with several seeds in parallel and keeping the best result.
+//!
+//! The transpiler's layout and routing are randomized, and the two-qubit gate count of the
+//! result varies a lot from seed to seed. Each trial runs `qk_transpile` with its own seed on a
+//! worker thread, against the worker's own copy of the target.
+
+use std::ffi::CStr;
+use std::mem::ManuallyDrop;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+
+use crate::backend_data::TargetData;
+use crate::fidelity::CircuitOperations;
+use crate::qiskit_circuit::Circuit;
+use crate::qiskit_ffi::{self, QkCircuit, QkTranspileOptions, QkTranspileResult};
+use crate::qiskit_target::Target;
+
+/// How [transpile_best_of] chooses among its trials.
+#[derive(Copy, Clone, Debug, Default, PartialEq, Eq)]
+#[repr(u32)]
+pub enum TranspileSelection {
+    /// The fewest two-qubit gates, then the highest estimated success probability.
+    #[default]
+    FewestTwoQubitGates = 0,
+    /// The highest estimated success probability, then the fewest two-qubit gates.
+    HighestSuccessProbability = 1,
+}
+
+impl TryFrom<u32> for TranspileSelection {
+    type Error = u32;
+
+    fn try_from(value: u32) -> Result<Self, u32> {
+        match value {
+            0 => Ok(TranspileSelection::FewestTwoQubitGates),
+            1 => Ok(TranspileSelection::HighestSuccessProbability),
+            _ => Err(value),
+        }
+    }
+}
+
+/// The outcome of one trial of [transpile_best_of].
+#[repr(C)]
+#[derive(Copy, Clone, Debug, Default, PartialEq)]
+pub struct TranspileTrial {
+    pub seed: i64,
+    /// The exit code of ``qk_transpile``. The counts are only set when it is 0.
+    pub exit_code: u32,
+    pub two_qubit_gates: usize,
+    pub success_probability: f64,
+}
+
+/// A transpiled circuit and layout, freed on drop unless taken.
+pub(crate) struct Transpiled(QkTranspileResult);
+
+// The result is exclusively owned by this handle, so moving it to another thread is sound.
+unsafe impl Send for Transpiled {}
+
+impl Transpiled {
+    fn into_inner(self) -> QkTranspileResult {
+        ManuallyDrop::new(self).0
+    }
+
+    /// The transpiled circuit, freeing the layout.
+    pub fn into_circuit(self) -> Circuit {
+        let result = self.into_inner();
+        unsafe { qiskit_ffi::qk_transpile_layout_free(result.layout) };
+        Circuit(result.circuit)
+    }
+}
+
+impl Drop for Transpiled {
+    fn drop(&mut self) {
+        unsafe {
+            qiskit_ffi::qk_circuit_free(self.0.circuit);
+            qiskit_ffi::qk_transpile_layout_free(self.0.layout);
+        }
+    }
+}
+
+/// The input circuit, shared by the workers.
+struct SharedCircuit(*const QkCircuit);
+
+// `qk_transpile` only reads the input circuit, so concurrent trials may share it.
+unsafe impl Sync for SharedCircuit {}
+
+/// Run ``qk_transpile``, returning the result or its exit code and error message.
+pub(crate) fn transpile(
+    circuit: *const QkCircuit,
+    target: &Target,
+    options: &QkTranspileOptions,
+) -> Result<Transpiled, (u32, String)> {
+    let mut result = QkTranspileResult {
+        circuit: std::ptr::null_mut(),
+        layout: std::ptr::null_mut(),
+    };
+    let mut error = std::ptr::null_mut();
+    let exit_code =
+        unsafe { qiskit_ffi::qk_transpile(circuit, target.0, options, &mut result, &mut error) };
+    if exit_code == 0 {
+        return Ok(Transpiled(result));
+    }
+    let message = if error.is_null() {
+        format!("qk_transpile failed with exit code {}", exit_code)
+    } else {
+        let message = unsafe { CStr::from_ptr(error) }
+            .to_string_lossy()
+            .into_owned();
+        unsafe { qiskit_ffi::qk_str_free(error) };
+        message
+    };
+    Err((exit_code, message))
+}
+
+/// Run one trial, returning the result or the transpiler's error message.
+fn run_trial(
+    circuit: &SharedCircuit,
+    target: &Target,
+    options: &QkTranspileOptions,
+    data: &TargetData,
+) -> (TranspileTrial, Result<Transpiled, String>) {
+    let mut trial = TranspileTrial {
+        seed: options.seed,
+        success_probability: f64::NAN,
+        ..Default::default()
+    };
+    let transpiled = match transpile(circuit.0, target, options) {
+        Ok(transpiled) => transpiled,
+        Err((exit_code, message)) => {
+            trial.exit_code = exit_code;
+            return (trial, Err(message));
+        }
+    };
+    let output = Circuit(transpiled.0.circuit);
+    let mut two_qubit_gates = 0;
+    let operations = CircuitOperations::new(output.get_circuit_instructions().inspect(|inst| {
+        if inst.qubits.len() == 2 && inst.name != "barrier" {
+            two_qubit_gates += 1;
+        }
+    }));
+    trial.two_qubit_gates = two_qubit_gates;
+    trial.success_probability = operations.log_success_probability(data).exp();
+    (trial, Ok(transpiled))
+}
+
+/// The index of the best successful trial.
+fn select_best(trials: &[TranspileTrial], selection: TranspileSelection) -> Option<usize> {
+    let mut best: Option<usize> = None;
+    for (i, trial) in trials.iter().enumerate() {
+        if trial.exit_code != 0 {
+            continue;
+        }
+        let better = best.map_or(true, |b| {
+            let b = &trials[b];
+            let fewer = trial.two_qubit_gates.cmp(&b.two_qubit_gates).reverse();
+            let likelier = trial.success_probability.total_cmp(&b.success_probability);
+            let order = match selection {
+                TranspileSelection::FewestTwoQubitGates => fewer.then(likelier),
+                TranspileSelection::HighestSuccessProbability => likelier.then(fewer),
+            };
+            order.is_gt()
+        });
+        if better {
+            best = Some(i);
+        }
+    }
+    best
+}
+
+/// Transpile `circuit` for `target`, built from `data`, with `num_trials` seeds on up to one
+/// thread per core, and return the best result with the outcome of every trial. The outcomes
+/// are returned even when every trial fails.
+///
+/// Trial `i` uses seed `options.seed + i`, or `i` if `options.seed` is negative.
+pub(crate) fn transpile_best_of(
+    circuit: &Circuit,
+    target: &Target,
+    data: &TargetData,
+    num_trials: u32,
+    options: &QkTranspileOptions,
+    selection: TranspileSelection,
+) -> (Result<QkTranspileResult, String>, Vec<TranspileTrial>) {
+    if num_trials == 0 {
+        return (
+            Err("At least one transpilation trial is needed".to_string()),
+            Vec::new(),
+        );
+    }
+    let num_trials = num_trials as usize;
+    let workers = std::thread::available_parallelism()
+        .map_or(1, |n| n.get())
+        .min(num_trials);
+    let circuit = SharedCircuit(circuit.0);
+    let next = AtomicUsize::new(0);
+    let outcomes: Mutex<Vec<Option<(TranspileTrial, Result<Transpiled, String>)>>> =
+        Mutex::new((0..num_trials).map(|_| None).collect());
+    std::thread::scope(|scope| {
+        for target in (0..workers).map(|_| target.copy()) {
+            let (circuit, next, outcomes) = (&circuit, &next, &outcomes);
+            scope.spawn(move || loop {
+                let i = next.fetch_add(1, Ordering::Relaxed);
+                if i >= num_trials {
+                    return;
+                }
+                let mut options = *options;
+                options.seed = options.seed.max(0) + i as i64;
+                let outcome = run_trial(circuit, &target, &options, data);
+                outcomes.lock().unwrap()[i] = Some(outcome);
+            });
+        }
+    });
+    let (trials, mut results): (Vec<_>, Vec<_>) = outcomes
+        .into_inner()
+        .unwrap()
+        .into_iter()
+        .map(|outcome| outcome.unwrap())
+        .unzip();
+    let Some(best) = select_best(&trials, selection) else {
+        return (
+            Err(results.swap_remove(0).err().unwrap_or_default()),
+            trials,
+        );
+    };
+    let best = results.swap_remove(best).ok().unwrap().into_inner();
+    (Ok(best), trials)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn trial(exit_code: u32, two_qubit_gates: usize, success_probability: f64) -> TranspileTrial {
+        TranspileTrial {
+            seed: 0,
+            exit_code,
+            two_qubit_gates,
+            success_probability,
+        }
+    }
+
+    #[test]
+    fn best_trial_follows_selection() {
+        let trials = [
+            trial(1, 0, f64::NAN),
+            trial(0, 120, 0.30),
+            trial(0, 100, 0.20),
+            trial(0, 100, 0.25),
+            trial(0, 110, 0.40),
+        ];
+        assert_eq!(
+            select_best(&trials, TranspileSelection::FewestTwoQubitGates),
+            Some(3)
+        );
+        assert_eq!(
+            select_best(&trials, TranspileSelection::HighestSuccessProbability),
+            Some(4)
+        );
+        assert_eq!(
+            select_best(&trials[..1], TranspileSelection::FewestTwoQubitGates),
+            None
+        );
+    }
+
+    #[test]
+    fn transpile_selection_from_u32() {
+        for selection in [
+            TranspileSelection::FewestTwoQubitGates,
+            TranspileSelection::HighestSuccessProbability,
+        ] {
+            assert_eq!(
+                TranspileSelection::try_from(selection as u32),
+                Ok(selection)
+            );
+        }
+        assert_eq!(TranspileSelection::try_from(2), Err(2));
+    }
+}
@@ -102,9 +102,9 @@ pub async fn get_backend_configuration(
     let content_type = super::ContentType::from(content_type);
 
     if !status.is_client_error() && !status.is_server_error() {
-        let content = resp.text().await?;
+        let mut content = Vec::from(resp.bytes().await?);
         match content_type {
-            ContentType::Json => serde_json::from_str(&content).map_err(Error::from),
+            ContentType::Json => super::decode_json(&mut content).map_err(Error::from),
             ContentType::Text => Err(Error::from(serde_json::Error::custom("Received `text/plain` content type response that cannot be converted to `std::collections::HashMap&lt;String, serde_json::Value&gt;`"))),
             ContentType::Unsupported(unknown_type) => Err(Error::from(serde_json::Error::custom(format!("Received `{unknown_type}` content type response that cannot be converted to `std::collections::HashMap&lt;String, serde_json::Value&gt;`")))),
         }
@@ -119,6 +119,76 @@ pub async fn get_backend_configuration(
     }
 }
 
+/// Returns the configuration for the specified backend as the raw JSON bytes of the response.
+///
+/// This lets callers parse the document into borrowed types, e.g. with
+/// [`crate::apis::decode_json`], instead of a [`serde_json::Value`] tree. See
+/// [`get_backend_configuration`] for the required ``ibm_api_version``.
+pub async fn get_backend_configuration_bytes(
+    configuration: &configuration::Configuration,
+    id: &str,
+    crn: &str,
+    ibm_api_version: Option<&str>,
+) -> Result<Vec<u8>, Error<GetBackendConfigurationError>> {
+    // add a prefix to parameters to efficiently prevent name collisions
+    let p_id = id;
+    let p_ibm_api_version = ibm_api_version;
+
+    let uri_str = format!(
+        "{}/v1/backends/{id}/configuration",
+        configuration.base_path,
+        id = crate::apis::urlencode(p_id)
+    );
+    let mut req_builder = configuration.client.request(reqwest::Method::GET, &uri_str);
+
+    if let Some(ref user_agent) = configuration.user_agent {
+        req_builder = req_builder.header(reqwest::header::USER_AGENT, user_agent.clone());
+    }
+    if let Some(param_value) = p_ibm_api_version {
+        req_builder = req_builder.header("IBM-API-Version", param_value.to_string());
+    }
+    if let Some(ref token) = configuration.bearer_access_token {
+        req_builder = req_builder.bearer_auth(token.to_owned());
+    };
+    if let Some(ref apikey) = configuration.api_key {
+        let key = apikey.key.clone();
+        let value = match apikey.prefix {
+            Some(ref prefix) => format!("{} {}", prefix, key),
+            None => key,
+        };
+        req_builder = req_builder.header("Authorization", value);
+    };
+    req_builder = req_builder.header("Service-CRN", crn.to_string());
+
+    let req = req_builder.build()?;
+    let resp = configuration.client.execute(req).await?;
+
+    let status = resp.status();
+    let content_type = resp
+        .headers()
+        .get("content-type")
+        .and_then(|v| v.to_str().ok())
+        .unwrap_or("application/octet-stream");
+    let content_type = super::ContentType::from(content_type);
+
+    if !status.is_client_error() && !status.is_server_error() {
+        let content = Vec::from(resp.bytes().await?);
+        match content_type {
+            ContentType::Json => Ok(content),
+            ContentType::Text => Err(Error::from(serde_json::Error::custom("Received `text/plain` content type response that cannot be converted to `Vec<u8>`"))),
+            ContentType::Unsupported(unknown_type) => Err(Error::from(serde_json::Error::custom(format!("Received `{unknown_type}` content type response that cannot be converted to `Vec<u8>`")))),
+        }
+    } else {
+        let content = resp.text().await?;
+        let entity: Option<GetBackendConfigurationError> = serde_json::from_str(&content).ok();
+        Err(Error::ResponseError(ResponseContent {
+            status,
+            content,
+            entity,
+        }))
+    }
+}
+
 /// Returns the defaults for the specified backend. Simulator backends may not support this.
 pub async fn get_backend_defaults(
     configuration: &configuration::Configuration,
@@ -256,9 +326,9 @@ pub async fn get_backend_properties(
     let content_type = super::ContentType::from(content_type);
 
     if !status.is_client_error() && !status.is_server_error() {
-        let content = resp.text().await?;
+        let mut content = Vec::from(resp.bytes().await?);
         match content_type {
-            ContentType::Json => serde_json::from_str(&content).map_err(Error::from),
+            ContentType::Json => super::decode_json(&mut content).map_err(Error::from),
             ContentType::Text => Err(Error::from(serde_json::Error::custom("Received `text/plain` content type response that cannot be converted to `std::collections::HashMap&lt;String, serde_json::Value&gt;`"))),
             ContentType::Unsupported(unknown_type) => Err(Error::from(serde_json::Error::custom(format!("Received `{unknown_type}` content type response that cannot be converted to `std::collections::HashMap&lt;String, serde_json::Value&gt;`")))),
         }
@@ -273,23 +343,32 @@ pub async fn get_backend_properties(
     }
 }
 
-/// Returns the status for the specified backend ID.
-pub async fn get_backend_status(
+/// Returns the properties for the specified backend as the raw JSON bytes of the response.
+///
+/// This lets callers parse the document into borrowed types, e.g. with
+/// [`crate::apis::decode_json`], instead of a [`serde_json::Value`] tree.
+pub async fn get_backend_properties_bytes(
     configuration: &configuration::Configuration,
     id: &str,
+    crn: &str,
     ibm_api_version: Option<&str>,
-) -> Result<models::BackendStatusResponse, Error<GetBackendStatusError>> {
+    updated_before: Option<String>,
+) -> Result<Vec<u8>, Error<GetBackendPropertiesError>> {
     // add a prefix to parameters to efficiently prevent name collisions
     let p_id = id;
     let p_ibm_api_version = ibm_api_version;
+    let p_updated_before = updated_before;
 
     let uri_str = format!(
-        "{}/v1/backends/{id}/status",
+        "{}/v1/backends/{id}/properties",
         configuration.base_path,
         id = crate::apis::urlencode(p_id)
     );
     let mut req_builder = configuration.client.request(reqwest::Method::GET, &uri_str);
 
+    if let Some(ref param_value) = p_updated_before {
+        req_builder = req_builder.query(&[("updated_before", &param_value.to_string())]);
+    }
     if let Some(ref user_agent) = configuration.user_agent {
         req_builder = req_builder.header(reqwest::header::USER_AGENT, user_agent.clone());
     }
@@ -307,21 +386,63 @@ pub async fn get_backend_status(
         };
         req_builder = req_builder.header("Authorization", value);
     };
-    if let Some(ref apikey) = configuration.api_key {
-        let key = apikey.key.clone();
-        let value = match apikey.prefix {
-            Some(ref prefix) => format!("{} {}", prefix, key),
-            None => key,
-        };
-        req_builder = req_builder.header("Backend-Authentication", value);
-    };
-    if let Some(ref apikey) = configuration.api_key {
-        let key = apikey.key.clone();
-        let value = match apikey.prefix {
-            Some(ref prefix) => format!("{} {}", prefix, key),
-            None => key,
-        };
-        req_builder = req_builder.header("external-service-token", value);
+    req_builder = req_builder.header("Service-CRN", crn.to_string());
+
+    let req = req_builder.build()?;
+    let resp = configuration.client.execute(req).await?;
+
+    let status = resp.status();
+    let content_type = resp
+        .headers()
+        .get("content-type")
+        .and_then(|v| v.to_str().ok())
+        .unwrap_or("application/octet-stream");
+    let content_type = super::ContentType::from(content_type);
+
+    if !status.is_client_error() && !status.is_server_error() {
+        let content = Vec::from(resp.bytes().await?);
+        match content_type {
+            ContentType::Json => Ok(content),
+            ContentType::Text => Err(Error::from(serde_json::Error::custom("Received `text/plain` content type response that cannot be converted to `Vec<u8>`"))),
+            ContentType::Unsupported(unknown_type) => Err(Error::from(serde_json::Error::custom(format!("Received `{unknown_type}` content type response that cannot be converted to `Vec<u8>`")))),
+        }
+    } else {
+        let content = resp.text().await?;
+        let entity: Option<GetBackendPropertiesError> = serde_json::from_str(&content).ok();
+        Err(Error::ResponseError(ResponseContent {
+            status,
+            content,
+            entity,
+        }))
+    }
+}
+
+/// Returns the status for the specified backend ID.
+pub async fn get_backend_status(
+    configuration: &configuration::Configuration,
+    id: &str,
+    crn: &str,
+    ibm_api_version: Option<&str>,
+) -> Result<models::BackendStatusResponse, Error<GetBackendStatusError>> {
+    // add a prefix to parameters to efficiently prevent name collisions
+    let p_id = id;
+    let p_ibm_api_version = ibm_api_version;
+
+    let uri_str = format!(
+        "{}/v1/backends/{id}/status",
+        configuration.base_path,
+        id = crate::apis::urlencode(p_id)
+    );
+    let mut req_builder = configuration.client.request(reqwest::Method::GET, &uri_str);
+
+    if let Some(ref user_agent) = configuration.user_agent {
+        req_builder = req_builder.header(reqwest::header::USER_AGENT, user_agent.clone());
+    }
+    if let Some(param_value) = p_ibm_api_version {
+        req_builder = req_builder.header("IBM-API-Version", param_value.to_string());
+    }
+    if let Some(ref token) = configuration.bearer_access_token {
+        req_builder = req_builder.bearer_auth(token.to_owned());
     };
     if let Some(ref apikey) = configuration.api_key {
         let key = apikey.key.clone();
@@ -329,8 +450,9 @@ pub async fn get_backend_status(
             Some(ref prefix) => format!("{} {}", prefix, key),
             None => key,
         };
-        req_builder = req_builder.header("Service-CRN", value);
+        req_builder = req_builder.header("Authorization", value);
     };
+    req_builder = req_builder.header("Service-CRN", crn.to_string());
 
     let req = req_builder.build()?;
     let resp = configuration.client.execute(req).await?;
@@ -220,6 +220,7 @@ pub async fn get_instance_configuration(
 /// Get instance usage
 pub async fn get_usage(
     configuration: &configuration::Configuration,
+    crn: &str,
     ibm_api_version: Option<&str>,
 ) -> Result<models::GetUsage200Response, Error<GetUsageError>> {
     // add a prefix to parameters to efficiently prevent name collisions
@@ -261,14 +262,15 @@ pub async fn get_usage(
         };
         req_builder = req_builder.header("external-service-token", value);
     };
-    if let Some(ref apikey) = configuration.api_key {
-        let key = apikey.key.clone();
-        let value = match apikey.prefix {
-            Some(ref prefix) => format!("{} {}", prefix, key),
-            None => key,
-        };
-        req_builder = req_builder.header("Service-CRN", value);
-    };
+    // if let Some(ref apikey) = configuration.api_key {
+    //     let key = apikey.key.clone();
+    //     let value = match apikey.prefix {
+    //         Some(ref prefix) => format!("{} {}", prefix, key),
+    //         None => key,
+    //     };
+    //     req_builder = req_builder.header("Service-CRN", value);
+    // };
+    req_builder = req_builder.header("Service-CRN", crn);
 
     let req = req_builder.build()?;
     let resp = configuration.client.execute(req).await?;
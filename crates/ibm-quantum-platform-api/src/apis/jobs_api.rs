@@ -576,6 +576,7 @@ pub async fn get_job_details_jid(
 /// Gets metrics of specified job
 pub async fn get_job_metrics_jid(
     configuration: &configuration::Configuration,
+    crn: &str,
     id: &str,
     ibm_api_version: Option<&str>,
 ) -> Result<models::JobMetrics, Error<GetJobMetricsJidError>> {
@@ -623,14 +624,15 @@ pub async fn get_job_metrics_jid(
         };
         req_builder = req_builder.header("external-service-token", value);
     };
-    if let Some(ref apikey) = configuration.api_key {
-        let key = apikey.key.clone();
-        let value = match apikey.prefix {
-            Some(ref prefix) => format!("{} {}", prefix, key),
-            None => key,
-        };
-        req_builder = req_builder.header("Service-CRN", value);
-    };
+    // if let Some(ref apikey) = configuration.api_key {
+    //     let key = apikey.key.clone();
+    //     let value = match apikey.prefix {
+    //         Some(ref prefix) => format!("{} {}", prefix, key),
+    //         None => key,
+    //     };
+    //     req_builder = req_builder.header("Service-CRN", value);
+    // };
+    req_builder = req_builder.header("Service-CRN", crn);
 
     let req = req_builder.build()?;
     let resp = configuration.client.execute(req).await?;
@@ -734,10 +736,10 @@ pub async fn get_job_results_jid(
     let content_type = super::ContentType::from(content_type);
 
     if !status.is_client_error() && !status.is_server_error() {
-        let content = resp.text().await?;
+        let mut content = Vec::from(resp.bytes().await?);
         match content_type {
-            ContentType::Json => serde_json::from_str(&content).map_err(Error::from),
-            ContentType::Text => serde_json::from_str(&content).map_err(Error::from),
+            ContentType::Json => super::decode_json(&mut content).map_err(Error::from),
+            ContentType::Text => super::decode_json(&mut content).map_err(Error::from),
             ContentType::Unsupported(unknown_type) => Err(Error::from(serde_json::Error::custom(format!("Received `{unknown_type}` content type response that cannot be converted to `String`")))),
         }
     } else {
@@ -1063,9 +1065,9 @@ pub async fn list_jobs(
     let content_type = super::ContentType::from(content_type);
 
     if !status.is_client_error() && !status.is_server_error() {
-        let content = resp.text().await?;
+        let mut content = Vec::from(resp.bytes().await?);
         match content_type {
-            ContentType::Json => serde_json::from_str(&content).map_err(Error::from),
+            ContentType::Json => super::decode_json(&mut content).map_err(Error::from),
             ContentType::Text => Err(Error::from(serde_json::Error::custom("Received `text/plain` content type response that cannot be converted to `models::JobsResponse`"))),
             ContentType::Unsupported(unknown_type) => Err(Error::from(serde_json::Error::custom(format!("Received `{unknown_type}` content type response that cannot be converted to `models::JobsResponse`")))),
         }
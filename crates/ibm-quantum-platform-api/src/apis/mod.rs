@@ -1,6 +1,8 @@
 use std::error;
 use std::fmt;
 
+use serde::Deserialize;
+
 #[derive(Debug, Clone)]
 pub struct ResponseContent<T> {
     pub status: reqwest::StatusCode,
@@ -12,6 +14,7 @@ pub struct ResponseContent<T> {
 pub enum Error<T> {
     Reqwest(reqwest::Error),
     Serde(serde_json::Error),
+    Decode(DecodeError),
     Io(std::io::Error),
     ResponseError(ResponseContent<T>),
 }
@@ -21,6 +24,7 @@ impl<T> fmt::Display for Error<T> {
         let (module, e) = match self {
             Error::Reqwest(e) => ("reqwest", e.to_string()),
             Error::Serde(e) => ("serde", e.to_string()),
+            Error::Decode(e) => ("decode", e.to_string()),
             Error::Io(e) => ("IO", e.to_string()),
             Error::ResponseError(e) => ("response", format!("status code {}", e.status)),
         };
@@ -33,6 +37,7 @@ impl<T: fmt::Debug> error::Error for Error<T> {
         Some(match self {
             Error::Reqwest(e) => e,
             Error::Serde(e) => e,
+            Error::Decode(e) => e,
             Error::Io(e) => e,
             Error::ResponseError(_) => return None,
         })
@@ -51,6 +56,12 @@ impl<T> From<serde_json::Error> for Error<T> {
     }
 }
 
+impl<T> From<DecodeError> for Error<T> {
+    fn from(e: DecodeError) -> Self {
+        Error::Decode(e)
+    }
+}
+
 impl<T> From<std::io::Error> for Error<T> {
     fn from(e: std::io::Error) -> Self {
         Error::Io(e)
@@ -113,6 +124,65 @@ impl From<&str> for ContentType {
     }
 }
 
+/// A JSON body a [JsonDecoder] couldn't decode, with the error of whichever engine it uses.
+#[derive(Debug)]
+pub struct DecodeError(Box<dyn error::Error + Send + Sync>);
+
+impl fmt::Display for DecodeError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        self.0.fmt(f)
+    }
+}
+
+impl error::Error for DecodeError {
+    fn source(&self) -> Option<&(dyn error::Error + 'static)> {
+        Some(self.0.as_ref())
+    }
+}
+
+/// Decodes a JSON response body.
+///
+/// The endpoints with large responses (job results, the job list and the backend configuration
+/// and properties) read their body as bytes and decode it through [decode_json] with
+/// [DefaultJsonDecoder], without copying it into a `String` first. The body is passed mutably
+/// so that engines that parse in place can be used; its contents are unspecified afterwards.
+pub trait JsonDecoder {
+    fn decode<'a, T: Deserialize<'a>>(body: &'a mut [u8]) -> Result<T, DecodeError>;
+}
+
+/// Decodes with `serde_json`, which validates UTF-8 only inside strings.
+pub struct SerdeJsonDecoder;
+
+impl JsonDecoder for SerdeJsonDecoder {
+    fn decode<'a, T: Deserialize<'a>>(body: &'a mut [u8]) -> Result<T, DecodeError> {
+        serde_json::from_slice(body).map_err(|e| DecodeError(Box::new(e)))
+    }
+}
+
+/// Decodes with `simd-json`, which finds the structure of the document with SIMD instructions
+/// selected for the CPU at run time, and unescapes strings in place in the body.
+#[cfg(feature = "simd-json")]
+pub struct SimdJsonDecoder;
+
+#[cfg(feature = "simd-json")]
+impl JsonDecoder for SimdJsonDecoder {
+    fn decode<'a, T: Deserialize<'a>>(body: &'a mut [u8]) -> Result<T, DecodeError> {
+        simd_json::serde::from_slice(body).map_err(|e| DecodeError(Box::new(e)))
+    }
+}
+
+/// The engine of [decode_json]: [SimdJsonDecoder] with the `simd-json` feature, otherwise
+/// [SerdeJsonDecoder].
+#[cfg(feature = "simd-json")]
+pub type DefaultJsonDecoder = SimdJsonDecoder;
+#[cfg(not(feature = "simd-json"))]
+pub type DefaultJsonDecoder = SerdeJsonDecoder;
+
+/// Decode a response body with [DefaultJsonDecoder]. Borrowed strings in `T` point into `body`.
+pub fn decode_json<'a, T: Deserialize<'a>>(body: &'a mut [u8]) -> Result<T, DecodeError> {
+    DefaultJsonDecoder::decode(body)
+}
+
 pub mod accounts_api;
 pub mod analytics_api;
 pub mod backends_api;
@@ -24,6 +24,7 @@ pub enum FindInstanceWorkloadsError {
 /// List user instance workloads
 pub async fn find_instance_workloads(
     configuration: &configuration::Configuration,
+    crn: &str,
     ibm_api_version: Option<&str>,
     user: Option<&str>,
     sort: Option<&str>,
@@ -157,14 +158,15 @@ pub async fn find_instance_workloads(
         };
         req_builder = req_builder.header("external-service-token", value);
     };
-    if let Some(ref apikey) = configuration.api_key {
-        let key = apikey.key.clone();
-        let value = match apikey.prefix {
-            Some(ref prefix) => format!("{} {}", prefix, key),
-            None => key,
-        };
-        req_builder = req_builder.header("Service-CRN", value);
-    };
+    // if let Some(ref apikey) = configuration.api_key {
+    //     let key = apikey.key.clone();
+    //     let value = match apikey.prefix {
+    //         Some(ref prefix) => format!("{} {}", prefix, key),
+    //         None => key,
+    //     };
+    //     req_builder = req_builder.header("Service-CRN", value);
+    // };
+    req_builder = req_builder.header("Service-CRN", crn);
 
     let req = req_builder.build()?;
     let resp = configuration.client.execute(req).await?;
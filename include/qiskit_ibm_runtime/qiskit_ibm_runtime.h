@@ -11,12 +11,310 @@
 // that they have been altered from the originals.
 
 #include <qiskit.h>
+#include <stdbool.h>
 
 typedef struct Service Service;
 typedef struct Job Job;
 typedef struct Backend Backend;
 typedef struct BackendSearchResults BackendSearchResults;
 typedef struct Samples Samples;
+typedef struct BackendWatcher BackendWatcher;
+typedef struct CouplingGraph CouplingGraph;
+typedef struct IsaReport IsaReport;
+typedef struct Pipeline Pipeline;
+typedef struct BackendTarget BackendTarget;
+
+/**
+ * What ``qkrt_backend_best_subset`` minimizes.
+ */
+enum SubsetObjective {
+    /** Two-qubit gate and readout errors, weighted equally. */
+    SubsetObjective_Balanced = 0,
+    /** Only two-qubit gate errors. */
+    SubsetObjective_TwoQubit = 1,
+    /** Only readout errors. */
+    SubsetObjective_Readout = 2,
+};
+
+/**
+ * Why an instruction reported by ``qkrt_validate_isa`` can't run on the backend.
+ */
+enum IsaViolationKind {
+    /** The backend has no such instruction. */
+    IsaViolationKind_UnsupportedOperation = 0,
+    /** A qubit is beyond the backend's qubits. */
+    IsaViolationKind_QubitOutOfRange = 1,
+    /**
+     * The backend doesn't support the instruction on these qubits, e.g. a
+     * two-qubit gate between uncoupled qubits or against the coupler's
+     * direction.
+     */
+    IsaViolationKind_UnsupportedQubits = 2,
+};
+
+/**
+ * An instruction of a circuit that can't run on a backend as is.
+ */
+typedef struct IsaViolation {
+    /** The index of the instruction in the circuit. */
+    size_t instruction;
+    enum IsaViolationKind kind;
+} IsaViolation;
+
+/**
+ * How ``qkrt_transpile_best_of`` chooses among its trials.
+ */
+enum TranspileSelection {
+    /** The fewest two-qubit gates, then the highest estimated success probability. */
+    TranspileSelection_FewestTwoQubitGates = 0,
+    /** The highest estimated success probability, then the fewest two-qubit gates. */
+    TranspileSelection_HighestSuccessProbability = 1,
+};
+
+/**
+ * The outcome of one trial of ``qkrt_transpile_best_of``.
+ */
+typedef struct TranspileTrial {
+    /** The transpiler seed of the trial. */
+    int64_t seed;
+    /** The exit code of ``qk_transpile``. The other fields are only set when it is 0. */
+    uint32_t exit_code;
+    size_t two_qubit_gates;
+    /** As computed by ``qkrt_estimate_success_probability``. */
+    double success_probability;
+} TranspileTrial;
+
+/**
+ * The stages of a ``Pipeline``, in the order circuits go through them.
+ */
+enum PipelineStage {
+    /** Fetching the backend's target, once when the pipeline starts. */
+    PipelineStage_Target = 0,
+    PipelineStage_Transpile = 1,
+    PipelineStage_IsaCheck = 2,
+    /** Encoding the circuit as compressed QPY in a job request. */
+    PipelineStage_Encode = 3,
+    PipelineStage_Submit = 4,
+};
+
+/**
+ * Options of ``qkrt_pipeline_new``.
+ */
+typedef struct PipelineOptions {
+    /** Threads transpiling circuits, or 0 for one per core. */
+    uint32_t transpile_workers;
+    /** Threads encoding jobs, or 0 for 2. */
+    uint32_t encode_workers;
+    /** Jobs submitted at once, or 0 for 4. */
+    uint32_t submit_workers;
+    /**
+     * Circuits waiting for each stage before the stage feeding it blocks, or 0
+     * for 16.
+     */
+    uint32_t queue_capacity;
+    /** Shots of each job, or 0 for the sampler's default. */
+    int32_t shots;
+    QkTranspileOptions transpile;
+} PipelineOptions;
+
+/**
+ * The progress of one stage of a ``Pipeline``.
+ */
+typedef struct PipelineStageStats {
+    /** Circuits the stage passed on. */
+    uint64_t processed;
+    /** Circuits that failed in the stage. */
+    uint64_t failed;
+    /** Circuits waiting for the stage. */
+    size_t queue_depth;
+    /** The most circuits that waited for the stage at once. */
+    size_t max_queue_depth;
+    /** Time the stage's workers spent working, summed over the workers. */
+    double busy_seconds;
+    /** Circuits processed per second since the pipeline started. */
+    double throughput;
+} PipelineStageStats;
+
+/**
+ * Options controlling how ``qkrt_service_new_with_options`` brings up a service.
+ */
+typedef struct ServiceOptions {
+    /** Path of the account configuration file, or NULL for ``~/.qiskit/qiskit-ibm.json``. */
+    const char *filename;
+    /** Name of the account to use, or NULL for the default account. */
+    const char *account_name;
+    /** List the backends on a background thread while the caller carries on. */
+    bool prefetch_backends;
+    /** Also build the targets of all listed backends in the background. */
+    bool prefetch_targets;
+    /**
+     * Seconds for which instance discovery and backend listings are served
+     * from the on-disk discovery cache, or 0 to disable the cache.
+     */
+    uint64_t discovery_cache_ttl;
+    /**
+     * List a backend reachable from several instances only once, through the
+     * instance with the least load, and submit jobs to it through whichever of
+     * those instances is least loaded at the time. See
+     * ``qkrt_backend_instance_load``.
+     */
+    bool balance_instances;
+    /**
+     * The most built targets kept in memory, or 0 for the default of 32. Past
+     * that the least recently used targets are dropped from memory and loaded
+     * again from the on-disk cache when next needed.
+     */
+    uint32_t max_cached_targets;
+    /**
+     * Check every circuit with ``qkrt_validate_isa`` before
+     * ``qkrt_sampler_job_run`` submits it, and fail with ``BadArgumentError``
+     * instead of submitting a circuit the backend can't run.
+     */
+    bool validate_isa;
+} ServiceOptions;
+
+/**
+ * The outcome of ``qkrt_backend_target_refresh``.
+ */
+typedef struct TargetRefresh {
+    /** Gate entries whose duration or error changed and were updated. */
+    uint32_t updated;
+    /** Entries whose properties did not change. */
+    uint32_t unchanged;
+    /**
+     * Entries that changed but cannot be updated in place: measurements, resets
+     * and gates on qubits the target doesn't have them on. Get a new target with
+     * ``qkrt_backend_target_new`` to pick these up.
+     */
+    uint32_t not_applied;
+} TargetRefresh;
+
+/**
+ * The load of the instance a backend is used through, as considered when
+ * choosing between several instances that reach the same backend.
+ */
+typedef struct InstanceLoad {
+    /** The number of instances the backend was reachable from, or 0 if no choice was made. */
+    uint32_t candidates;
+    /** Pending and in-progress workloads of the instance on the backend. */
+    uint32_t active_workloads;
+    /** Usage consumed by the instance in the current period. */
+    double usage_consumed_seconds;
+    /** The usage limit of the instance, or 0 if it has none. */
+    double usage_limit_seconds;
+    /** Whether the instance has reached its usage limit. */
+    bool usage_limit_reached;
+} InstanceLoad;
+
+/**
+ * The operational status of a backend.
+ */
+enum BackendStatus {
+    /** The backend is accepting and running jobs. */
+    BackendStatus_Online = 0,
+    /** The backend accepts jobs but is not currently running them. */
+    BackendStatus_Paused = 1,
+    /** The backend is unavailable. */
+    BackendStatus_Offline = 2,
+};
+
+/**
+ * Whether ``qkrt_backend_search_filtered`` includes simulators.
+ */
+enum SimulatorFilter {
+    /** Include both simulators and hardware backends. */
+    SimulatorFilter_Any = 0,
+    /** Only include hardware backends. */
+    SimulatorFilter_Exclude = 1,
+    /** Only include simulators. */
+    SimulatorFilter_Only = 2,
+};
+
+/**
+ * Filter criteria and ranking weights for ``qkrt_backend_search_filtered``.
+ *
+ * Matching backends are ranked by the weighted sum of their queue length,
+ * CLOPS and layered two-qubit error, each scaled to [0, 1] across the matches
+ * so that 0 is the best value. A backend that does not report a metric gets
+ * the worst value for it. A zero-initialized filter matches every backend and
+ * keeps listing order.
+ */
+typedef struct BackendFilter {
+    /** Minimum number of qubits, or 0 for any. */
+    uint32_t min_qubits;
+    /** Only match backends that are online. */
+    bool operational_only;
+    /** A ``SimulatorFilter``. */
+    uint32_t simulator;
+    /** Processor family to match (case-insensitive), e.g. "Heron", or NULL for any. */
+    const char *processor_family;
+    /** Weight of the queue length in the ranking score. */
+    double queue_length_weight;
+    /** Weight of CLOPS in the ranking score. */
+    double clops_weight;
+    /** Weight of the layered two-qubit error in the ranking score. */
+    double two_q_error_weight;
+    /** Maximum number of results, or 0 for all matches. */
+    size_t top_k;
+} BackendFilter;
+
+/**
+ * Wall-clock seconds spent in each phase of bringing up a service.
+ *
+ * Phases that run in the background, or lazily on first use, are zero until
+ * they complete. Because some phases overlap, the phase times need not add up
+ * to ``total``.
+ */
+typedef struct StartupTimings {
+    /** Reading and parsing the account configuration file. */
+    double config;
+    /** Exchanging the API key for an IAM access token. */
+    double iam_token;
+    /** Resolving the instances the service submits through. */
+    double instance_discovery;
+    /** Listing the backends of every instance. */
+    double backend_listing;
+    /** Fetching and building the targets of the listed backends. */
+    double target_prefetch;
+    /** Time until the service handle was returned to the caller. */
+    double total;
+} StartupTimings;
+
+/**
+ * A prediction of the seconds from submitting a job until its results are
+ * available.
+ */
+typedef struct CompletionPrediction {
+    /** Time spent waiting in the backend's queue. */
+    double queue_wait;
+    /** Time spent running on the backend. */
+    double execution;
+    /** The sum of ``queue_wait`` and ``execution``. */
+    double total;
+} CompletionPrediction;
+
+/**
+ * The QPU time of a job, in seconds, estimated from the durations a backend
+ * reports.
+ */
+typedef struct QpuTimeEstimate {
+    /** The critical path of one shot. */
+    double schedule_seconds;
+    /** The delay between shots. */
+    double rep_delay;
+    /** The whole job, including the fixed cost of starting it. */
+    double total_seconds;
+} QpuTimeEstimate;
+
+/**
+ * What submitting a sampler job would involve, from
+ * ``qkrt_sampler_job_dry_run``.
+ */
+typedef struct SamplerDryRun {
+    QpuTimeEstimate qpu_time;
+    /** The size of the job request that would be posted, in bytes. */
+    size_t payload_bytes;
+} SamplerDryRun;
 
 /**
  * Allocate a new Qiskit IBM Runtime Client service instance.
@@ -24,6 +322,10 @@ typedef struct Samples Samples;
  * You must free the service with ``qkrt_service_free`` when you're done
  * with it.
  *
+ * Only the account's access token is fetched here. Instance discovery is
+ * deferred until the first ``qkrt_backend_search``; if the account config
+ * pins an instance CRN, only that instance is looked up.
+ *
  * @param[out] out A pointer to where the newly allocated service's handle
  *     will be written.
  *
@@ -44,6 +346,68 @@ typedef struct Samples Samples;
  */
 extern int32_t qkrt_service_new(Service **out);
 
+/**
+ * Allocate a new Qiskit IBM Runtime Client service instance with the given options.
+ *
+ * With ``prefetch_backends`` set, instance discovery and backend listing start on
+ * a background thread as soon as the access token is available, and the first
+ * ``qkrt_backend_search`` uses that listing. With ``prefetch_targets`` set, the
+ * targets of the listed backends are also built in the background, at most 8
+ * backends at a time and no more than the target cache holds, and put in the
+ * target cache used by ``qkrt_get_backend_target``.
+ *
+ * With a non-zero ``discovery_cache_ttl``, instance discovery and backend
+ * listings are persisted under ``$QISKIT_IBM_RUNTIME_CACHE_DIR`` (by default
+ * ``~/.qiskit/cache/qiskit-ibm-runtime-c``) and, while younger than the TTL,
+ * ``qkrt_backend_search`` is served from disk without network requests. The
+ * live fields of a cached backend can be updated with
+ * ``qkrt_backend_refresh_status``.
+ *
+ * You must free the service with ``qkrt_service_free`` when you're done
+ * with it.
+ *
+ * @param[out] out A pointer to where the newly allocated service's handle
+ *     will be written.
+ * @param options The options to use, or NULL for the defaults used by
+ *     ``qkrt_service_new``.
+ *
+ * @return An exit code to indicate the status of the call.
+ *
+ * # Example
+ *
+ *     ServiceOptions options = {NULL, NULL, true, false, 3600, false};
+ *     Service *service;
+ *     int res = qkrt_service_new_with_options(&service, &options);
+ *     if (res != 0) {
+ *         printf("service new failed with code: %d\n", res);
+ *         return res;
+ *     }
+ */
+extern int32_t qkrt_service_new_with_options(Service **out, ServiceOptions *options);
+
+/**
+ * Get the time spent in each phase of bringing up the service so far.
+ *
+ * @param[out] out A pointer to where the timings will be written.
+ * @param service A handle to the service.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_service_startup_timings(StartupTimings *out, Service *service);
+
+/**
+ * Drop the service's cached instances and backend listings and rediscover them.
+ *
+ * If the discovery cache is enabled, the on-disk cache is rewritten from a
+ * fresh listing before this returns; otherwise discovery reruns on the next
+ * ``qkrt_backend_search``.
+ *
+ * @param service A handle to the service.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_service_refresh(Service *service);
+
 /**
  * Free a Qiskit IBM Runtime Client service instance.
  *
@@ -57,6 +421,9 @@ extern void qkrt_service_free(Service *service);
  * If the service was configured without specifying an instance, the search
  * results will include all backends accessible via the account.
  *
+ * The first search on a service also discovers its instances, so it may
+ * report Global Search errors.
+ *
  * @param[out] out A pointer to where the newly allocated search result listing's
  *     handle will be written.
  * @param service A handle to the service to search.
@@ -65,6 +432,63 @@ extern void qkrt_service_free(Service *service);
  */
 extern int32_t qkrt_backend_search(BackendSearchResults **out, Service *service);
 
+/**
+ * Build the targets of the best-ranked backends of a search in the background,
+ * so that ``qkrt_get_backend_target`` for them is served from memory.
+ *
+ * The call returns immediately. The configuration and properties of at most
+ * ``max_concurrent`` backends are fetched at once, and no more targets are
+ * built than the service keeps in memory (see
+ * ``ServiceOptions.max_cached_targets``). A ``qkrt_get_backend_target`` call
+ * for a backend whose target is being built waits for it rather than fetching
+ * it again. Failures are logged and otherwise ignored.
+ *
+ * @param results The search results.
+ * @param service The service handle the results were obtained from.
+ * @param top_n The number of backends, from the start of the results, whose
+ *     targets to build, or 0 for all of them.
+ * @param max_concurrent The most backends to fetch at once, or 0 for the
+ *     default of 8.
+ *
+ * # Example
+ *
+ *     BackendSearchResults *results;
+ *     qkrt_backend_search_filtered(&results, service, &filter);
+ *     qkrt_backend_search_results_prefetch_targets(results, service, 3, 0);
+ */
+extern void qkrt_backend_search_results_prefetch_targets(BackendSearchResults *results,
+                                                         Service *service, uint32_t top_n,
+                                                         uint32_t max_concurrent);
+
+/**
+ * Search the backends available via the provided service handle for those
+ * matching ``filter``, best-ranked first.
+ *
+ * # Example
+ *
+ *     BackendFilter filter = {0};
+ *     filter.min_qubits = 100;
+ *     filter.operational_only = true;
+ *     filter.simulator = SimulatorFilter_Exclude;
+ *     filter.processor_family = "Heron";
+ *     filter.queue_length_weight = 1.0;
+ *     filter.two_q_error_weight = 2.0;
+ *     filter.top_k = 3;
+ *     BackendSearchResults *results;
+ *     qkrt_backend_search_filtered(&results, service, &filter);
+ *
+ * @param[out] out A pointer to where the newly allocated search result listing's
+ *     handle will be written.
+ * @param service A handle to the service to search.
+ * @param filter The filter criteria and ranking weights, or NULL to match
+ *     every backend.
+ *
+ * @return An exit code to indicate the status of the call. If ``simulator``
+ *     isn't a ``SimulatorFilter`` value, ``BadArgumentError`` is returned.
+ */
+extern int32_t qkrt_backend_search_filtered(BackendSearchResults **out, Service *service,
+                                            const BackendFilter *filter);
+
 extern void qkrt_backend_search_results_free(BackendSearchResults *results);
 
 extern uint64_t qkrt_backend_search_results_length(BackendSearchResults *results);
@@ -84,7 +508,467 @@ extern Backend** qkrt_backend_search_results_data(BackendSearchResults *results)
  */
 extern Backend* qkrt_backend_search_results_least_busy(BackendSearchResults *results);
 
-extern QkTarget* qkrt_get_backend_target(Service *service , Backend *backend);
+/**
+ * A helper function to find and return a handle to the backend predicted to
+ * return the results of a circuit soonest from the given search results.
+ *
+ * See ``qkrt_backend_predict_completion`` for how the prediction is made. The
+ * function does not perform additional network requests.
+ *
+ * @param results The results to search.
+ * @param service The service handle.
+ * @param circuit The circuit to be run.
+ * @param shots The number of shots, or -1 for the sampler's default.
+ *
+ * @return A handle to the backend with the lowest predicted time to result.
+ *     If the results list is empty, NULL.
+ */
+extern Backend* qkrt_backend_search_results_least_time(BackendSearchResults *results,
+                                                       Service *service, QkCircuit *circuit,
+                                                       int32_t shots);
+
+/**
+ * Build the transpiler target of a backend.
+ *
+ * The backend's configuration and properties are fetched concurrently. Built
+ * targets are cached in memory and under ``$QISKIT_IBM_RUNTIME_CACHE_DIR``,
+ * keyed by backend name and the calibration time of the properties, and a
+ * cache hit hands out a copy. For a minute after a target is built or checked
+ * it is handed out without network requests; after that the properties are
+ * fetched again, and the target is rebuilt only if the backend has been
+ * calibrated since.
+ *
+ * @param[out] out A pointer to where the newly allocated target will be written.
+ *     The caller owns the target and frees it with ``qk_target_free``.
+ *     On failure NULL is written.
+ * @param service The service handle.
+ * @param backend The backend to build the target of.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_get_backend_target(QkTarget **out, Service *service, Backend *backend);
+
+/**
+ * Build the target of a backend as a handle that can be refreshed.
+ *
+ * The target comes from the same cache as ``qkrt_get_backend_target``. The
+ * handle also keeps the properties the target was built from, so that
+ * ``qkrt_backend_target_refresh`` can later update it in place.
+ *
+ * @param[out] out A pointer to where the newly allocated handle will be written.
+ *     The caller owns the handle and frees it with ``qkrt_backend_target_free``.
+ *     On failure NULL is written.
+ * @param service The service handle.
+ * @param backend The backend to build the target of.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_backend_target_new(BackendTarget **out, Service *service, Backend *backend);
+
+/**
+ * Get the transpiler target held by a handle.
+ *
+ * @param target The handle, obtained from ``qkrt_backend_target_new``.
+ *
+ * @return The target. It is owned by the handle, stays valid until the handle
+ *     is freed and must not be freed with ``qk_target_free``.
+ */
+extern QkTarget *qkrt_backend_target_get(const BackendTarget *target);
+
+/**
+ * Bring a target up to date with the backend's latest calibration in place.
+ *
+ * The backend's properties are compared with those the target was last brought
+ * up to date with, and only the gate durations and errors that changed are
+ * written with ``qk_target_update_property``. The target object, and anything
+ * the transpiler has cached about it, stays alive. The latest properties come
+ * from the same cache as ``qkrt_get_backend_target``.
+ *
+ * Entries that are not applied, such as measurement and reset properties,
+ * which a target can't take, are reported as not applied again on every later
+ * refresh until the target is rebuilt.
+ *
+ * @param[out] out A pointer to where the counts of updated, unchanged and not
+ *     applied entries will be written.
+ * @param service The service handle.
+ * @param target The handle to update, obtained from ``qkrt_backend_target_new``.
+ *     The caller keeps ownership of it.
+ *
+ * @return An exit code to indicate the status of the call.
+ *
+ * # Example
+ *
+ *     TargetRefresh refresh;
+ *     int res = qkrt_backend_target_refresh(&refresh, service, target);
+ *     if (res == 0 && refresh.not_applied > 0) {
+ *         qkrt_backend_target_free(target);
+ *         res = qkrt_backend_target_new(&target, service, backend);
+ *     }
+ */
+extern int32_t qkrt_backend_target_refresh(TargetRefresh *out, Service *service,
+                                           BackendTarget *target);
+
+/**
+ * Free a handle obtained from ``qkrt_backend_target_new``, along with its target.
+ *
+ * @param target The handle to free. If NULL, nothing is done.
+ */
+extern void qkrt_backend_target_free(BackendTarget *target);
+
+/**
+ * Get the coupling map of a backend, weighted with the error and duration of
+ * its two-qubit gate on each edge and the readout error of each qubit.
+ *
+ * The graph is in compressed sparse row form: the edges leaving qubit ``q``
+ * go to ``columns[row_offsets[q]]`` up to but excluding
+ * ``columns[row_offsets[q + 1]]``, in increasing order, and the edge error and
+ * duration arrays are indexed like ``columns``. Edges are directed as the
+ * backend reports the gate, so a coupler with a symmetric gate such as CZ
+ * appears in both rows. Fractional RZZ gates only count on backends without
+ * another two-qubit gate. Unknown values are NaN, and durations are in seconds.
+ *
+ * The graph is built from the same properties, and kept in the same cache, as
+ * ``qkrt_get_backend_target``, and is built once per calibration. Handles
+ * share it, so getting it again is cheap.
+ *
+ * @param[out] out A pointer to where the graph handle will be written. Free it
+ *     with ``qkrt_coupling_graph_free``. On failure NULL is written.
+ * @param service The service handle.
+ * @param backend The backend to get the coupling map of.
+ *
+ * @return An exit code to indicate the status of the call.
+ *
+ * # Example
+ *
+ *     CouplingGraph *graph;
+ *     int res = qkrt_backend_coupling_graph(&graph, service, backend);
+ *     const uint32_t *offsets = qkrt_coupling_graph_row_offsets(graph);
+ *     const uint32_t *columns = qkrt_coupling_graph_columns(graph);
+ *     const double *errors = qkrt_coupling_graph_edge_errors(graph);
+ *     for (uint32_t q = 0; q < qkrt_coupling_graph_num_qubits(graph); q++) {
+ *         for (uint32_t e = offsets[q]; e < offsets[q + 1]; e++) {
+ *             printf("%u -> %u: %g\n", q, columns[e], errors[e]);
+ *         }
+ *     }
+ *     qkrt_coupling_graph_free(graph);
+ */
+extern int32_t qkrt_backend_coupling_graph(CouplingGraph **out, Service *service,
+                                           Backend *backend);
+
+/** The number of qubits, i.e. rows, of a coupling graph. */
+extern uint32_t qkrt_coupling_graph_num_qubits(CouplingGraph *graph);
+
+/** The number of directed edges of a coupling graph. */
+extern size_t qkrt_coupling_graph_num_edges(CouplingGraph *graph);
+
+/**
+ * The ``num_qubits + 1`` row offsets of a coupling graph. The array lives as
+ * long as the graph handle.
+ */
+extern const uint32_t* qkrt_coupling_graph_row_offsets(CouplingGraph *graph);
+
+/** The ``num_edges`` target qubits of the edges of a coupling graph. */
+extern const uint32_t* qkrt_coupling_graph_columns(CouplingGraph *graph);
+
+/** The ``num_edges`` two-qubit gate errors of the edges of a coupling graph. */
+extern const double* qkrt_coupling_graph_edge_errors(CouplingGraph *graph);
+
+/** The ``num_edges`` two-qubit gate durations, in seconds, of a coupling graph. */
+extern const double* qkrt_coupling_graph_edge_durations(CouplingGraph *graph);
+
+/** The ``num_qubits`` readout errors of a coupling graph. */
+extern const double* qkrt_coupling_graph_readout_errors(CouplingGraph *graph);
+
+/** Free a coupling graph handle. */
+extern void qkrt_coupling_graph_free(CouplingGraph *graph);
+
+/**
+ * Check that a circuit only uses instructions a backend supports, on qubits it
+ * supports them on, without submitting it.
+ *
+ * Every instruction is checked in one pass against the backend's gates,
+ * measurements and resets, including the direction of two-qubit gates.
+ * Barriers only need their qubits to exist. The properties come from the same
+ * cache as ``qkrt_get_backend_target``.
+ *
+ * @param[out] out A pointer to where the report will be written. Free it with
+ *     ``qkrt_isa_report_free``. On failure NULL is written.
+ * @param service The service handle.
+ * @param backend The backend to check the circuit against.
+ * @param circuit The circuit to check.
+ *
+ * @return An exit code to indicate the status of the call. A circuit with
+ *     violations is still a successful call.
+ *
+ * # Example
+ *
+ *     IsaReport *report;
+ *     int res = qkrt_validate_isa(&report, service, backend, circuit);
+ *     const IsaViolation *violations = qkrt_isa_report_violations(report);
+ *     for (size_t i = 0; i < qkrt_isa_report_num_violations(report); i++) {
+ *         printf("instruction %zu: %d\n", violations[i].instruction, violations[i].kind);
+ *     }
+ *     qkrt_isa_report_free(report);
+ */
+extern int32_t qkrt_validate_isa(IsaReport **out, Service *service, Backend *backend,
+                                 QkCircuit *circuit);
+
+/** The number of violations in a report, 0 for an ISA circuit. */
+extern size_t qkrt_isa_report_num_violations(IsaReport *report);
+
+/**
+ * The violations in a report, in instruction order. The array lives as long as
+ * the report.
+ */
+extern const IsaViolation* qkrt_isa_report_violations(IsaReport *report);
+
+/** Free a report from ``qkrt_validate_isa``. */
+extern void qkrt_isa_report_free(IsaReport *report);
+
+/**
+ * Estimate the probability that an ISA circuit for a backend runs without
+ * error.
+ *
+ * The estimated success probability (ESP) is the product of ``1 - error`` over
+ * every instruction of the circuit, using the gate, measurement and reset
+ * errors the backend reports on the instruction's qubits. It is summed as
+ * logarithms for precision. Barriers are ignored, and instructions without a
+ * reported error count as perfect. An instruction the backend doesn't support
+ * on its qubits gives 0. The properties come from the same cache as
+ * ``qkrt_get_backend_target``.
+ *
+ * @param[out] out A pointer to where the probability will be written.
+ * @param service The service handle.
+ * @param backend The backend the circuit was transpiled for.
+ * @param circuit The circuit to score.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_estimate_success_probability(double *out, Service *service, Backend *backend,
+                                                 QkCircuit *circuit);
+
+/**
+ * Estimate the probability that a circuit runs without error on each of
+ * several backends, as ``qkrt_estimate_success_probability`` does for one.
+ *
+ * The backends' properties are fetched concurrently, the circuit is read once,
+ * and it is scored against the backends in parallel. The circuit's instructions
+ * must be supported by a backend for it to score above 0, so this ranks
+ * backends that share a gate set, such as the results of a backend search.
+ *
+ * @param[out] out An array of ``num_backends`` entries, where the probability
+ *     on each backend will be written.
+ * @param service The service handle.
+ * @param backends An array of ``num_backends`` backends.
+ * @param num_backends The number of backends.
+ * @param circuit The circuit to score.
+ *
+ * @return An exit code to indicate the status of the call.
+ *
+ * # Example
+ *
+ *     size_t n = qkrt_backend_search_results_length(results);
+ *     double *esp = malloc(n * sizeof(double));
+ *     int res = qkrt_estimate_success_probabilities(
+ *         esp, service, qkrt_backend_search_results_data(results), n, circuit);
+ */
+extern int32_t qkrt_estimate_success_probabilities(double *out, Service *service,
+                                                   Backend *const *backends, size_t num_backends,
+                                                   QkCircuit *circuit);
+
+/**
+ * Transpile a circuit for a backend, reusing an earlier result when the same
+ * circuit was already transpiled with the same options.
+ *
+ * Results are kept as QPY files under
+ * ``$QISKIT_IBM_RUNTIME_CACHE_DIR/transpiled``, keyed by a SHA-256 digest of
+ * the circuit's instructions, qubits and parameters, the backend's name and
+ * calibration, and the transpiler options. A hit is read back without running ``qk_transpile``, and
+ * a recalibration of the backend makes every result for it miss. Only the
+ * circuit is kept, not the layout of the transpilation. Once the directory
+ * grows past 256 MiB, the least recently used results are removed.
+ *
+ * Only transpilations with a fixed, non-negative seed are cached. With a
+ * negative seed, such as the one of ``qk_transpiler_default_options()``, the
+ * circuit is transpiled on every call.
+ *
+ * @param[out] out A pointer to where the transpiled circuit will be written.
+ *     Free it with ``qk_circuit_free``.
+ * @param service The service handle.
+ * @param backend The backend to transpile for.
+ * @param circuit The circuit to transpile.
+ * @param options The transpiler options, or NULL for
+ *     ``qk_transpiler_default_options()``.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_transpile_cached(QkCircuit **out, Service *service, Backend *backend,
+                                     QkCircuit *circuit, const QkTranspileOptions *options);
+
+/**
+ * Start a pipeline that transpiles circuits for a backend and submits them as
+ * sampler jobs.
+ *
+ * Each stage has its own worker threads: ``qk_transpile`` against the
+ * backend's cached target, an ISA check as done by ``qkrt_validate_isa``,
+ * encoding the job request with the circuit as compressed QPY, and submission.
+ * The stages are connected by bounded queues. A full queue blocks the stage
+ * feeding it, and a full transpile queue blocks ``qkrt_pipeline_submit``, so a
+ * slow stage holds back the ones before it instead of letting circuits pile
+ * up in memory.
+ *
+ * @param[out] out A pointer to where the pipeline handle will be written.
+ *     Free it with ``qkrt_pipeline_free``. On failure NULL is written.
+ * @param service The service handle.
+ * @param backend The backend to run the circuits on, for example from
+ *     ``qkrt_backend_search_results_least_busy``.
+ * @param options The options, or NULL for the defaults with
+ *     ``qk_transpiler_default_options()``.
+ *
+ * @return An exit code to indicate the status of the call.
+ *
+ * # Example
+ *
+ *     Pipeline *pipeline = NULL;
+ *     int res = qkrt_pipeline_new(&pipeline, service, backend, NULL);
+ *     for (size_t i = 0; i < num_circuits; i++) {
+ *         qkrt_pipeline_submit(pipeline, circuits[i]);
+ *     }
+ *     Job **jobs = malloc(num_circuits * sizeof(Job *));
+ *     res = qkrt_pipeline_finish(jobs, pipeline);
+ *     PipelineStageStats stats[5];
+ *     qkrt_pipeline_stats(stats, pipeline);
+ *     qkrt_pipeline_free(pipeline);
+ */
+extern int32_t qkrt_pipeline_new(Pipeline **out, Service *service, Backend *backend,
+                                 const PipelineOptions *options);
+
+/**
+ * Queue an untranspiled circuit, waiting while the transpile queue is full.
+ *
+ * @param pipeline The pipeline handle.
+ * @param circuit The circuit to run. On success the pipeline takes ownership
+ *     of it and frees it once transpiled. On failure the caller keeps it.
+ *
+ * @return An exit code to indicate the status of the call.
+ *     ``BadArgumentError`` is returned if the pipeline is already finished.
+ */
+extern int32_t qkrt_pipeline_submit(Pipeline *pipeline, QkCircuit *circuit);
+
+/** The number of circuits queued with ``qkrt_pipeline_submit``. */
+extern size_t qkrt_pipeline_num_circuits(Pipeline *pipeline);
+
+/**
+ * Wait until every queued circuit has been submitted or has failed. No more
+ * circuits can be queued afterwards.
+ *
+ * @param[out] jobs An array of ``qkrt_pipeline_num_circuits`` entries, where
+ *     the job of each circuit will be written in the order they were queued,
+ *     or NULL for a circuit that failed. Free each job with ``qkrt_job_free``.
+ *     Can be NULL to discard the jobs.
+ * @param pipeline The pipeline handle.
+ *
+ * @return An exit code to indicate the status of the call. If any circuit
+ *     failed, this is the error of the first one, and every failure is logged.
+ */
+extern int32_t qkrt_pipeline_finish(Job **jobs, Pipeline *pipeline);
+
+/**
+ * Report the progress of each stage of a pipeline.
+ *
+ * @param[out] out An array of 5 entries, indexed by ``PipelineStage``.
+ * @param pipeline The pipeline handle.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_pipeline_stats(PipelineStageStats *out, Pipeline *pipeline);
+
+/** Free a pipeline, waiting for the circuits it still has. */
+extern void qkrt_pipeline_free(Pipeline *pipeline);
+
+/**
+ * Transpile a circuit for a backend with several seeds in parallel and keep
+ * the best result.
+ *
+ * Layout and routing are randomized, so the two-qubit gate count of the output
+ * varies from seed to seed. Trial ``i`` runs ``qk_transpile`` with seed
+ * ``options->seed + i``, or ``i`` if the seed is negative, on up to one thread
+ * per core. Each thread works on its own copy of the backend's target, which
+ * comes from the same cache as ``qkrt_get_backend_target``. The trials are
+ * compared by their two-qubit gate count and estimated success probability,
+ * in the order given by ``selection``.
+ *
+ * @param[out] out A pointer to where the best result will be written. Free its
+ *     circuit with ``qk_circuit_free`` and its layout with
+ *     ``qk_transpile_layout_free``.
+ * @param[out] trials An array of ``num_trials`` entries, where the outcome of
+ *     each trial will be written, or NULL. The outcomes are written whenever
+ *     the trials ran, including when every trial fails.
+ * @param service The service handle.
+ * @param backend The backend to transpile for.
+ * @param circuit The circuit to transpile.
+ * @param num_trials The number of seeds to try, at least 1.
+ * @param options The transpiler options, or NULL for
+ *     ``qk_transpiler_default_options()``.
+ * @param selection How the best trial is chosen, as a ``TranspileSelection``.
+ *
+ * @return An exit code to indicate the status of the call. If every trial
+ *     fails, ``BadArgumentError`` is returned with the first trial's error. If
+ *     ``selection`` isn't a ``TranspileSelection`` value, no trial is run and
+ *     ``BadArgumentError`` is returned.
+ *
+ * # Example
+ *
+ *     QkTranspileResult result;
+ *     TranspileTrial trials[16];
+ *     int res = qkrt_transpile_best_of(&result, trials, service, backend, circuit, 16, NULL,
+ *                                      TranspileSelection_FewestTwoQubitGates);
+ */
+extern int32_t qkrt_transpile_best_of(QkTranspileResult *out, TranspileTrial *trials,
+                                      Service *service, Backend *backend, QkCircuit *circuit,
+                                      uint32_t num_trials, const QkTranspileOptions *options,
+                                      uint32_t selection);
+
+/**
+ * Build the transpiler target of the connected region of ``k`` qubits of a
+ * backend with the lowest errors.
+ *
+ * Each qubit is weighted with its readout error and each coupler with the
+ * error of the backend's two-qubit gate on it, both as ``-ln(1 - error)``. A
+ * region is scored by the mean weight of its couplers and of its qubits,
+ * weighted according to ``objective``. The region is grown greedily from every
+ * qubit in turn, so the result is a good region rather than a proven best one.
+ * The properties come from the same cache as ``qkrt_get_backend_target``.
+ *
+ * Transpiling against the smaller target is faster than against the whole
+ * backend. The qubits of the transpiled circuit are the target's qubits, so
+ * map them through ``qubits`` to the backend's physical qubits before running
+ * the circuit on the backend.
+ *
+ * @param[out] out A pointer to where the newly allocated target of ``k``
+ *     qubits will be written. The caller owns the target and frees it with
+ *     ``qk_target_free``. On failure NULL is written.
+ * @param[out] qubits An array of ``k`` entries, where the physical qubit of
+ *     each qubit of the target will be written, in increasing order.
+ * @param service The service handle.
+ * @param backend The backend to choose the qubits of.
+ * @param k The number of qubits to choose.
+ * @param objective The errors to minimize, as a ``SubsetObjective``.
+ *
+ * @return An exit code to indicate the status of the call. If ``k`` is 0,
+ *     larger than the backend, or larger than any connected part of it, or if
+ *     ``objective`` isn't a ``SubsetObjective`` value, ``BadArgumentError`` is
+ *     returned.
+ *
+ * # Example
+ *
+ *     uint32_t qubits[72];
+ *     QkTarget *target;
+ *     int res = qkrt_backend_best_subset(&target, qubits, service, backend, 72,
+ *                                        SubsetObjective_Balanced);
+ */
+extern int32_t qkrt_backend_best_subset(QkTarget **out, uint32_t *qubits, Service *service,
+                                        Backend *backend, uint32_t k, uint32_t objective);
 
 /**
  * Get the name of the provided backend.
@@ -113,9 +997,174 @@ extern char* qkrt_backend_instance_crn(Backend *backend);
  */
 extern char* qkrt_backend_instance_name(Backend *backend);
 
+/**
+ * Get the number of jobs queued on the provided backend.
+ *
+ * This is the value from the search or the most recent status refresh.
+ *
+ * @param A handle to the backend.
+ *
+ * @return The queue length of the backend.
+ */
+extern int32_t qkrt_backend_queue_length(Backend *backend);
+
+/**
+ * Get the operational status of the provided backend.
+ *
+ * This is the value from the search or the most recent status refresh.
+ *
+ * @param A handle to the backend.
+ *
+ * @return The ``BackendStatus`` of the backend.
+ */
+extern uint32_t qkrt_backend_status(Backend *backend);
+
+/**
+ * Get the load of the instance through which the provided backend is used.
+ *
+ * With ``balance_instances`` set in the service options, a backend reachable
+ * from several instances is listed once, through the instance that is under its
+ * usage limit, has the fewest pending and in-progress workloads on the backend,
+ * and has used the smallest fraction of its usage limit, in that order. The
+ * choice is logged at the INFO level. For backends where no choice was made,
+ * ``candidates`` is 0.
+ *
+ * This is the load at search time. Jobs submitted to the backend go through
+ * the instance that is least loaded at submission, which may be another of the
+ * candidates. Loads are reused for 30 seconds, so searches and submissions in
+ * quick succession don't fetch them again.
+ *
+ * The function does not perform additional network requests.
+ *
+ * @param[out] out A pointer to where the load will be written.
+ * @param backend A handle to the backend.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_backend_instance_load(InstanceLoad *out, Backend *backend);
+
+/**
+ * Fetch the current status and queue length of a backend and update the
+ * handle in place.
+ *
+ * @param service A handle to the service.
+ * @param backend A handle to the backend.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_backend_refresh_status(Service *service, Backend *backend);
+
+/**
+ * Predict the time from submitting a circuit to a backend until its results are
+ * available.
+ *
+ * The queue wait is the backend's last known queue length times the wait per
+ * queued job learned from previous jobs on the backend. The execution time is
+ * an estimate of the circuit's QPU time, corrected by the ratio of actual to
+ * estimated QPU time of previous jobs. What is learned from jobs is persisted
+ * under ``$QISKIT_IBM_RUNTIME_CACHE_DIR`` (by default
+ * ``~/.qiskit/cache/qiskit-ibm-runtime-c``); until a backend has been
+ * observed, a default of 30 seconds per queued job is used.
+ *
+ * A job is learned from once, after it finishes, when its results are fetched
+ * with ``qkrt_job_results`` or ``qkrt_job_predict_completion`` is called for
+ * it. This function does not perform network requests.
+ *
+ * @param[out] out A pointer to where the prediction will be written.
+ * @param service The service handle.
+ * @param backend The backend to run on.
+ * @param circuit The circuit to be run.
+ * @param shots The number of shots, or -1 for the sampler's default.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_backend_predict_completion(CompletionPrediction *out, Service *service,
+                                               Backend *backend, QkCircuit *circuit,
+                                               int32_t shots);
+
+/**
+ * Called from a backend watcher's thread when a watched backend changes.
+ *
+ * @param index The position of the backend in the watched search results, as
+ *     in ``qkrt_backend_search_results_data``.
+ * @param status The new ``BackendStatus`` of the backend.
+ * @param queue_length The new queue length of the backend.
+ * @param user_data The ``user_data`` given to ``qkrt_backend_watcher_new``.
+ */
+typedef void (*BackendStatusCallback)(size_t index, enum BackendStatus status,
+                                      int32_t queue_length, void *user_data);
+
+/**
+ * Start watching the status and queue length of the backends in a search result.
+ *
+ * A background thread polls every watched backend each ``interval_ms`` and
+ * updates the backend handles in place, so ``qkrt_backend_status`` and
+ * ``qkrt_backend_queue_length`` stay current without further calls. The
+ * callback is invoked on that thread whenever a backend's status changes
+ * (e.g. it goes offline) or its queue length moves by more than
+ * ``queue_threshold`` since it was last reported. The callback must not free
+ * the watcher.
+ *
+ * When the service's access token expires the watcher gets a new one. A
+ * backend whose status can't be fetched for 3 polls in a row is reported
+ * offline, and reported again once a poll succeeds.
+ *
+ * The search results may be freed while the watcher runs, though the callback
+ * then can't look up the backend by its index. You must free the watcher with
+ * ``qkrt_backend_watcher_free`` to stop it.
+ *
+ * # Example
+ *
+ *     void on_change(size_t index, enum BackendStatus status,
+ *                    int32_t queue_length, void *user_data) {
+ *         Backend *backend = qkrt_backend_search_results_data(user_data)[index];
+ *         printf("%s: status %d, %d jobs queued\n", qkrt_backend_name(backend),
+ *                status, queue_length);
+ *     }
+ *
+ *     BackendWatcher *watcher;
+ *     qkrt_backend_watcher_new(&watcher, service, results, 30000, 10, on_change, results);
+ *     // ...
+ *     qkrt_backend_watcher_free(watcher);
+ *
+ * @param[out] out A pointer to where the newly allocated watcher's handle will
+ *     be written.
+ * @param service A handle to the service.
+ * @param results The search results whose backends to watch.
+ * @param interval_ms Milliseconds between polls. Must be positive.
+ * @param queue_threshold The queue length change that triggers the callback.
+ * @param callback The function to notify, or NULL to only keep the handles
+ *     current.
+ * @param user_data Passed through to ``callback``.
+ *
+ * @return An exit code to indicate the status of the call. If ``interval_ms``
+ *     is 0, no watcher is started and ``BadArgumentError`` is returned.
+ */
+extern int32_t qkrt_backend_watcher_new(BackendWatcher **out, Service *service,
+                                        BackendSearchResults *results, uint64_t interval_ms,
+                                        int32_t queue_threshold, BackendStatusCallback callback,
+                                        void *user_data);
+
+/**
+ * Stop a backend watcher and free it.
+ *
+ * This waits for an in-progress poll to finish.
+ *
+ * @param watcher A handle to the watcher to free.
+ */
+extern void qkrt_backend_watcher_free(BackendWatcher *watcher);
+
 /**
  * Submit a new job given a circuit and the backend to run it on.
  *
+ * The circuit must be transpiled for the backend. Fractional-gate backends run
+ * ``rzz`` only with angles in [0, pi/2], which the target cannot express, so
+ * other ``rzz`` angles are rewritten into equivalent gates (``rz``, ``x`` and an
+ * in-range ``rzz``) and ``rx`` angles are wrapped into (-pi, pi] on submission.
+ * With ``ServiceOptions.validate_isa`` set, the circuit is first checked with
+ * ``qkrt_validate_isa`` and ``BadArgumentError`` is returned if it has any
+ * violation.
+ *
  * You must free the allocated job instance with ``qkrt_job_free`` when you're done
  * with it.
  *
@@ -130,6 +1179,52 @@ extern char* qkrt_backend_instance_name(Backend *backend);
  */
 extern int32_t qkrt_sampler_job_run(Job **out, Service *service, Backend *backend, QkCircuit *circuit, int32_t shots, char *runtime);
 
+/**
+ * Prepare a job as ``qkrt_sampler_job_run`` does, without submitting it.
+ *
+ * The circuit is always checked with ``qkrt_validate_isa``, and
+ * ``BadArgumentError`` is returned if it has any violation. Then the full job
+ * request is built, with the circuit encoded as compressed QPY. Its size and
+ * the job's QPU time, as ``qkrt_estimate_qpu_time`` estimates it with the
+ * default delay between shots, are reported. Use this to budget a batch
+ * before submitting it.
+ *
+ * @param[out] out A pointer to where the report will be written.
+ * @param service A handle to the service.
+ * @param backend A handle to the backend.
+ * @param circuit A handle to the circuit to run.
+ * @param shots The number of shots for this run, or a negative number for the
+ *     sampler's default.
+ * @param runtime The name of the runtime.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_sampler_job_dry_run(SamplerDryRun *out, Service *service, Backend *backend,
+                                        QkCircuit *circuit, int32_t shots, char *runtime);
+
+/**
+ * Estimate the QPU time of running an ISA circuit on a backend.
+ *
+ * Each shot takes the critical path of the circuit, where every instruction
+ * starts once all its qubits are free. An instruction takes the duration the
+ * backend reports for it on its qubits, such as the gate length or the readout
+ * length, or a typical duration if none is reported. Barriers take no time but
+ * synchronize their qubits. The durations come from the same cache as
+ * ``qkrt_get_backend_target``.
+ *
+ * @param[out] out A pointer to where the estimate will be written.
+ * @param service A handle to the service.
+ * @param backend A handle to the backend.
+ * @param circuit A handle to the circuit to run.
+ * @param shots The number of shots, or a negative number for the sampler's
+ *     default.
+ * @param rep_delay The delay between shots in seconds, or 0 for 250 us.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_estimate_qpu_time(QpuTimeEstimate *out, Service *service, Backend *backend,
+                                      QkCircuit *circuit, int32_t shots, double rep_delay);
+
 /**
  * Check the status of the provided job.
  *
@@ -141,6 +1236,23 @@ extern int32_t qkrt_sampler_job_run(Job **out, Service *service, Backend *backen
  */
 extern int32_t qkrt_job_status(uint32_t *out, Service *service, Job *job);
 
+/**
+ * Predict the remaining time until the results of a submitted job are
+ * available.
+ *
+ * This fetches the job's metrics. When the service provides an estimated
+ * completion time it is used directly; otherwise the prediction follows
+ * ``qkrt_backend_predict_completion`` with the job's position in the queue. A
+ * finished job predicts zero.
+ *
+ * @param[out] out A pointer to where the prediction will be written.
+ * @param service The service handle.
+ * @param job The handle of the job to query.
+ *
+ * @return An exit code to indicate the status of the call.
+ */
+extern int32_t qkrt_job_predict_completion(CompletionPrediction *out, Service *service, Job *job);
+
 /**
  * Free the provided job.
  *
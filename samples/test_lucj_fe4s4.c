@@ -55,7 +55,12 @@ int main(int argc, char *arv[]) {
     printf("selected backed: %s\n", qkrt_backend_name(backends[selected_backend]));
 
     // Transpile circuit for backend
-    QkTarget *target = qkrt_get_backend_target(service, backends[selected_backend]);
+    QkTarget *target;
+    res = qkrt_get_backend_target(&target, service, backends[selected_backend]);
+    if (res != 0) {
+        printf("target fetch failed with code: %d\n", res);
+        goto cleanup_service;
+    }
     QkTranspileResult transpile_result = {NULL, NULL};
     char *error = NULL;
     QkTranspileOptions options = qk_transpiler_default_options();
@@ -25,6 +25,14 @@ int main(int argc, char* arv[]) {
             qk_circuit_gate(qc, QkGate_CZ, qubits, NULL);
         }
     }
+    // Fractional gates, with angles outside the range backends accept.
+    for(int j = 0; j<200; j+=2) {
+        uint32_t qubits[2] = {j, j + 1};
+        double rzz_params[1] = {-2.5};
+        double rx_params[1] = {7.0};
+        qk_circuit_gate(qc, QkGate_RZZ, qubits, rzz_params);
+        qk_circuit_gate(qc, QkGate_RX, qubits, rx_params);
+    }
     for(int i = 0; i < 200; i++) {
         qk_circuit_measure(qc, i, i);
     }